@@ -0,0 +1,108 @@
+// analysis.h
+// Analysis of many positions at once on a pool of engines.
+//
+// Offline jobs (puzzle verification, book generation, game annotation)
+// search large numbers of unrelated positions.  BatchAnalyzer runs them on
+// a fixed set of worker threads, each owning one SearchEngine with its
+// slice of the transposition table memory, so that a job costs one
+// process however many positions it has.  Positions are queued with
+// submit() and their results delivered as they complete; the queue is
+// bounded, so a producer reading positions from a stream never holds more
+// than a few per worker in memory.  analyzeBatch() wraps this for a
+// vector of positions.
+//
+// Every position is searched from scratch: the engine's table and history
+// are cleared between positions (SearchConfig::persistentTT and
+// keepHistory are ignored), so a result does not depend on which worker
+// took the position or what it searched before.  With depth or node
+// limits, results are reproducible.
+
+#ifndef GOMOKU_ANALYSIS_H
+#define GOMOKU_ANALYSIS_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "move_list.h"
+#include "search.h"
+#include "search_stats.h"
+
+namespace gomoku {
+
+struct AnalysisOptions {
+    // Settings of every worker's engine.  ttSizeMb is the total for all
+    // workers; each gets an equal share of at least one megabyte.
+    SearchConfig config;
+    // Time limit per position in milliseconds.  Set config.maxDepth or
+    // config.maxNodes for limits that do not depend on the machine.
+    int timeLimitMs = 1000;
+    // Number of worker threads.
+    int workers = 1;
+};
+
+struct AnalysisResult {
+    // Best move for the side to move, or (-1,-1) on a full board.
+    Move move;
+    // Score of the move for the side to move (see SearchStats::score).
+    int score = 0;
+    // Expected continuation, starting with move.
+    MoveList pv;
+    SearchStats stats;
+};
+
+class BatchAnalyzer {
+public:
+    // Called with the id given to submit() and the result, from the worker
+    // threads; calls are serialised.
+    typedef std::function<void(uint64_t id, const AnalysisResult &result)> ResultCallback;
+
+    BatchAnalyzer(const AnalysisOptions &options, ResultCallback onResult);
+    // Finishes the queued positions first.
+    ~BatchAnalyzer();
+    BatchAnalyzer(const BatchAnalyzer &) = delete;
+    BatchAnalyzer &operator=(const BatchAnalyzer &) = delete;
+
+    // Queue board for analysis under id.  Blocks while the queue is full.
+    void submit(uint64_t id, const Board &board);
+    // Wait until every submitted position has been analysed and stop the
+    // workers.  Nothing may be submitted afterwards.
+    void finish();
+
+private:
+    struct Job {
+        uint64_t id;
+        Board board;
+    };
+    // Positions queued per worker before submit() blocks.
+    static const std::size_t QUEUE_PER_WORKER = 4;
+
+    void work(SearchEngine &engine);
+
+    AnalysisOptions options;
+    ResultCallback onResult;
+    std::vector<std::unique_ptr<SearchEngine>> engines;
+    std::vector<std::thread> threads;
+
+    std::mutex queueLock;
+    std::condition_variable jobReady;
+    std::condition_variable spaceFree;
+    std::deque<Job> queue;
+    bool closing;
+    std::mutex callbackLock;
+};
+
+// Analyse every position of positions for its side to move; result i
+// belongs to position i.
+std::vector<AnalysisResult> analyzeBatch(const std::vector<Board> &positions,
+                                         const AnalysisOptions &options);
+
+} // namespace gomoku
+
+#endif // GOMOKU_ANALYSIS_H
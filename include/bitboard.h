@@ -0,0 +1,166 @@
+// bitboard.h
+// Whole-board bit operations for the 12×12 Gomoku board.
+//
+// A Bitboard is a 192-bit set split into three 64-bit words.  Cell (x,y)
+// lives at bit y*BOARD_STRIDE + x.  Moving every stone one step in a
+// direction is a single shift of the whole set by that direction's stride,
+// which lets patterns such as "five in a row" or "empty cell next to a
+// stone" be computed for the entire board with a handful of shifts and
+// ANDs instead of per-cell loops.
+//
+// Two layouts are available:
+//   * the default dense layout, BOARD_STRIDE = 12 (bits 0..143).  Shifts
+//     that move along a row wrap from column 11 into column 0 of the
+//     neighbouring row, so they must be masked after every step;
+//   * the padded layout, BOARD_STRIDE = 13, enabled by compiling with
+//     GOMOKU_PADDED_BITBOARD.  Every row carries an always-empty thirteenth
+//     column that absorbs the wrap-around, so no per-step masking is needed.
+
+#ifndef GOMOKU_BITBOARD_H
+#define GOMOKU_BITBOARD_H
+
+#include <cstdint>
+
+namespace gomoku {
+
+#ifdef GOMOKU_PADDED_BITBOARD
+const int BOARD_STRIDE = 13;
+#else
+const int BOARD_STRIDE = 12;
+#endif
+
+// Number of set bits in x.  Uses the compiler built-in where available and
+// Brian Kernighan's algorithm elsewhere.
+inline int popcount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    int cnt = 0;
+    while (x) {
+        x &= (x - 1);
+        ++cnt;
+    }
+    return cnt;
+#endif
+}
+
+// Index of the least significant set bit of x, which must be non-zero.
+inline int lowestBit(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int idx = 0;
+    while ((x & 1ULL) == 0ULL) {
+        x >>= 1;
+        ++idx;
+    }
+    return idx;
+#endif
+}
+
+struct Bitboard {
+    uint64_t w[3];
+
+    static Bitboard fromWords(const uint64_t words[3]) {
+        Bitboard b;
+        b.w[0] = words[0];
+        b.w[1] = words[1];
+        b.w[2] = words[2];
+        return b;
+    }
+    static Bitboard none() {
+        Bitboard b;
+        b.w[0] = b.w[1] = b.w[2] = 0ULL;
+        return b;
+    }
+
+    bool any() const { return (w[0] | w[1] | w[2]) != 0ULL; }
+    int count() const { return popcount64(w[0]) + popcount64(w[1]) + popcount64(w[2]); }
+    bool test(int bit) const { return ((w[bit >> 6] >> (bit & 63)) & 1ULL) != 0ULL; }
+    void set(int bit) { w[bit >> 6] |= 1ULL << (bit & 63); }
+    void clear(int bit) { w[bit >> 6] &= ~(1ULL << (bit & 63)); }
+
+    Bitboard operator&(const Bitboard &o) const {
+        Bitboard r;
+        r.w[0] = w[0] & o.w[0];
+        r.w[1] = w[1] & o.w[1];
+        r.w[2] = w[2] & o.w[2];
+        return r;
+    }
+    Bitboard operator|(const Bitboard &o) const {
+        Bitboard r;
+        r.w[0] = w[0] | o.w[0];
+        r.w[1] = w[1] | o.w[1];
+        r.w[2] = w[2] | o.w[2];
+        return r;
+    }
+    Bitboard andNot(const Bitboard &o) const {
+        Bitboard r;
+        r.w[0] = w[0] & ~o.w[0];
+        r.w[1] = w[1] & ~o.w[1];
+        r.w[2] = w[2] & ~o.w[2];
+        return r;
+    }
+
+    // Shift towards lower bit indices by n (0 < n < 64).
+    Bitboard shiftDown(int n) const {
+        Bitboard r;
+        r.w[0] = (w[0] >> n) | (w[1] << (64 - n));
+        r.w[1] = (w[1] >> n) | (w[2] << (64 - n));
+        r.w[2] = w[2] >> n;
+        return r;
+    }
+    // Shift towards higher bit indices by n (0 < n < 64).
+    Bitboard shiftUp(int n) const {
+        Bitboard r;
+        r.w[2] = (w[2] << n) | (w[1] >> (64 - n));
+        r.w[1] = (w[1] << n) | (w[0] >> (64 - n));
+        r.w[0] = w[0] << n;
+        return r;
+    }
+
+    // Call f(bit) for every set bit in ascending order.
+    template <typename F>
+    void forEach(F f) const {
+        for (int c = 0; c < 3; ++c) {
+            uint64_t word = w[c];
+            while (word) {
+                f(c * 64 + lowestBit(word));
+                word &= word - 1;
+            }
+        }
+    }
+};
+
+// Bit index of cell (x,y) in the active layout.
+inline int bitIndex(int x, int y) { return y * BOARD_STRIDE + x; }
+
+// The set of all on-board cells.
+Bitboard boardMask();
+
+// The four line directions as (dx,dy) = (1,0), (0,1), (1,1) and (-1,1).
+// Their bit strides are 1, BOARD_STRIDE, BOARD_STRIDE+1 and BOARD_STRIDE-1.
+const int NUM_DIRECTIONS = 4;
+
+// Move every cell one step backwards along direction dir: the result has
+// cell (x,y) set iff b has cell (x+dx, y+dy) set.  Cells whose source lies
+// off the board are cleared.
+Bitboard stepBack(const Bitboard &b, int dir);
+// The inverse step: cell (x,y) is set iff b has cell (x-dx, y-dy) set.
+Bitboard stepForward(const Bitboard &b, int dir);
+
+// True if b contains five consecutive cells along any direction.
+bool containsFive(const Bitboard &b);
+
+// All cells adjacent (including diagonally) to a cell of b, excluding the
+// cells of b itself.
+Bitboard neighbourhood(const Bitboard &b);
+
+// Cells where an open three "_XXX_" of own stones starts (the leading
+// empty cell) along any direction, given the player's stones and the
+// empty cells.
+Bitboard openThreeStarts(const Bitboard &own, const Bitboard &empty);
+
+} // namespace gomoku
+
+#endif // GOMOKU_BITBOARD_H
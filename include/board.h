@@ -7,6 +7,12 @@
 #include <cstdint>
 #include <vector>
 
+#include "bitboard.h"
+#include "network_eval.h"
+#include "placement_eval.h"
+#include "symmetry.h"
+#include "threat_index.h"
+
 namespace gomoku {
 
 // Representation of the two possible players.
@@ -15,6 +21,12 @@ enum class Player {
     White = 1
 };
 
+// The other player.  constexpr so that code templated on a Player can
+// name both colours as compile-time constants.
+constexpr Player opponentOf(Player p) {
+    return p == Player::Black ? Player::White : Player::Black;
+}
+
 // Simple struct to hold a move coordinate.
 struct Move {
     int x;
@@ -46,19 +58,59 @@ public:
     bool unmakeMove(int x, int y);
 
     // Check whether the specified player currently has five in a row.
-    bool checkWin(Player player) const;
+    // makeMove counts the stones in the windows through each new stone and
+    // records the move on which a player first completed five, so this is
+    // a flag read.
+    bool checkWin(Player player) const { return winPly[static_cast<int>(player)] >= 0; }
+
+    // True if either player has five in a row.
+    bool hasWinner() const { return winPly[0] >= 0 || winPly[1] >= 0; }
+
+    // True if a stone of player at the empty cell (x,y) would complete five
+    // in a row.  The board is not modified.
+    bool isWinningMove(int x, int y, Player player) const;
+
+    // --- Threat queries ---
+    // Sets of empty cells, in the layout of bitboard.h, describing the
+    // threats player can make or already has.  They are read from the
+    // board's ThreatIndex, so their cost depends on the number of threats,
+    // not on the size of the board.  A "four" is a five-cell
+    // window holding four stones of player and no opponent stone; a "live
+    // three" is a six-cell window whose two end cells are empty and whose
+    // four inner cells hold three stones of player and one empty cell, so
+    // that filling the gap makes an open four.
+    //
+    // Cells where a stone of player completes five.
+    Bitboard fivePoints(Player player) const;
+    // Cells where a stone of player makes a four.
+    Bitboard fourPoints(Player player) const;
+    // Cells where a stone of player makes a live three.
+    Bitboard threePoints(Player player) const;
+    // The window index itself, for callers that classify threats window
+    // by window.
+    const ThreatIndex &threats() const { return threatIndex; }
+    // The empty cells of player's live threes: the gaps that would make an
+    // open four and the end cells.  An opponent who does not play one of
+    // them (or make a four) faces an open four next move.
+    Bitboard threeDefences(Player player) const;
 
     // Get a list of legal (empty) positions on the board.
     std::vector<Move> getLegalMoves() const;
 
-    // Generate candidate moves within a bounding box around existing stones.
+    // Generate candidate moves close to existing stones.
     // This function is intended for use by the search engine.  It limits
-    // move generation to locations close to the action (within a margin of
-    // two cells of any existing stone) and ignores cells that have no
-    // neighboring stones.  If the board is empty (no stones), it will
-    // return the central location (5,5) as the only candidate.
+    // move generation to empty cells that have at least one neighboring
+    // stone (including diagonally).  If the board is empty (no stones), it
+    // will return the central location (5,5) as the only candidate.
     std::vector<Move> getCandidateMoves() const;
 
+    // The same candidate cells as getCandidateMoves() (apart from the
+    // empty-board and no-candidate fallbacks) as a bit set in the layout of
+    // bitboard.h.  The set is maintained incrementally by makeMove and
+    // unmakeMove, so reading it is free; iterate it with Bitboard::forEach
+    // to visit candidates without allocating.
+    const Bitboard &candidateMask() const { return candidates; }
+
     // Return a code describing the occupant of the cell at (x,y):
     // 0 = empty, 1 = black, 2 = white.  This helper is mainly for
     // evaluation purposes.
@@ -67,35 +119,142 @@ public:
     // Utility to count how many stones a player has on the board.
     int countStones(Player player) const;
 
+    // Whole-board views of the position in the layout of bitboard.h.
+    Bitboard stones(Player player) const { return Bitboard::fromWords(bb[static_cast<int>(player)]); }
+    Bitboard occupied() const { return stones(Player::Black) | stones(Player::White); }
+    Bitboard emptyCells() const { return boardMask().andNot(occupied()); }
+
     // Return the Zobrist hash key for the current position.  This value
     // uniquely represents the state of the board (including side to move) and
     // can be used by transposition tables.  It is updated incrementally as
     // moves are made and undone.
-    uint64_t getHashKey() const { return hashKey; }
+    uint64_t getHashKey() const { return symmetricKeys[0]; }
+
+    // Zobrist key of the image of the position under symmetry t (see
+    // symmetry.h), as getHashKey() of a board holding the transformed
+    // stones would return it.  All eight keys are maintained
+    // incrementally alongside getHashKey().
+    uint64_t symmetricKey(int t) const { return symmetricKeys[t]; }
+
+    // The smallest of the eight symmetric keys, which is the same for a
+    // position and all its mirror images and rotations.  transform
+    // receives the symmetry t that produced it: a move m of this position
+    // is move SYMMETRY.cellOf[t][m] of the canonical image, and a move c
+    // of the canonical image is SYMMETRY.cellOf[inverseSymmetry(t)][c]
+    // here.
+    uint64_t canonicalKey(int &transform) const;
+
+    // Sum of the line pattern scores (see pattern_eval.h) of player's stones
+    // over every row, column and diagonal.  The per-line scores are
+    // maintained incrementally by makeMove/unmakeMove, which look up only
+    // the four lines through the changed cell, so this is an O(1) read.
+    int lineScore(Player player) const { return lineTotal[static_cast<int>(player)]; }
+
+    // For each of the count empty cells cells[i] (index y*12+x), the
+    // value lineScore(player) - lineScore(opponent) would take after a
+    // stone of player is placed there, computed in one batch without
+    // modifying the board (see placement_eval.h).
+    void scorePlacements(Player player, const int *cells, int count, int *out,
+                         PlacementKernel kernel = PlacementKernel::Auto) const;
+
+    // --- Network evaluation (see network_eval.h) ---
+    // Attach network, or detach with nullptr.  While a network is
+    // attached, makeMove and unmakeMove keep its first layer output for
+    // both perspectives up to date, so networkScore is one pass over the
+    // small layers.  The network must outlive the attachment; copies of
+    // the board share it.
+    void attachNetwork(const Network *network);
+    const Network *attachedNetwork() const { return network; }
+    // The attached network's evaluation for player as the side to move.
+    int networkScore(Player player) const {
+        return network->evaluate(networkAccumulator, static_cast<int>(player));
+    }
+    // The accumulators themselves, for tests and benchmarks.
+    const NetworkAccumulator &accumulator() const { return networkAccumulator; }
+
+    // Number of distinct lines tracked by lineScore: 12 rows, 12 columns,
+    // 23 diagonals and 23 anti-diagonals (see line_geometry.h).
+    static const int NUM_LINES = 70;
 
 private:
-    // Convert a pair (x,y) into an index 0..143.
+    // Convert a pair (x,y) into a cell index 0..143.
     static inline int index(int x, int y) { return y * 12 + x; }
 
-    // Convert index into chunk 0..2 and bit offset 0..63.
-    static inline int chunkOf(int idx) { return idx >> 6; }
-    static inline int offsetOf(int idx) { return idx & 63; }
+    // Convert a bit index (see bitIndex) into chunk 0..2 and bit offset 0..63.
+    static inline int chunkOf(int bit) { return bit >> 6; }
+    static inline int offsetOf(int bit) { return bit & 63; }
 
-    // Bitboards for black and white. bb[player][chunk] holds bits for that player.
+    // Bitboards for black and white. bb[player][chunk] holds bits for that
+    // player, laid out by bitIndex().
     uint64_t bb[2][3];
 
     // The player who will make the next move.
     Player side_to_move;
 
+    // Cell codes as returned by getCellState, indexed by index(x,y).  This
+    // mirrors the bitboards and lets line scans read cells directly.
+    int8_t cells[144];
+
+    // Number of stones adjacent to each cell, and the set of empty cells
+    // with at least one adjacent stone.
+    uint8_t adjacentStones[144];
+    Bitboard candidates;
+
+    // Update the candidate set after a stone is placed on or removed from
+    // cell idx.  The cell state must already reflect the change.
+    void addToNeighbourhood(int idx);
+    void removeFromNeighbourhood(int idx);
+
+    // Line code (see pattern_eval.h) of each line from each player's point
+    // of view, the pattern score of each line for each player, and their
+    // sums.
+    int lineCodes[NUM_LINES][2];
+    int lineScores[NUM_LINES][2];
+    int lineTotal[2];
+
+    // Number of moves made since construction, and for each player the
+    // value of moveCount after the move that first gave them five in a row
+    // (-1 if they have none).  unmakeMove clears the flag when it takes
+    // back that move.
+    int moveCount;
+    int winPly[2];
+
+    // Five- and six-cell windows with their stone counts, updated with
+    // every stone placed or removed.
+    ThreatIndex threatIndex;
+    // Empty cells of a set of five-cell windows of player p.
+    Bitboard windowCells(const ThreatIndex::WindowSet &windows, int p) const;
+
+    // Rescore one line for both players from its codes and update
+    // lineTotal.
+    void rescoreLine(int line);
+    // Update the codes and scores of the four lines through cell idx after
+    // a stone of player p was placed there (sign = 1) or removed (-1).
+    void updateLinesThrough(int idx, int p, int sign);
+
+    // Network kept up to date by makeMove/unmakeMove (nullptr for none)
+    // and its first layer output for the current stones.
+    const Network *network;
+    NetworkAccumulator networkAccumulator;
+
     // --- Zobrist hashing support ---
     // Static tables storing random 64‑bit numbers for each board cell and player.
     // These are initialized on first construction of a Board via initZobrist().
     static bool zobristInitialized;
     static uint64_t zobristTable[12][12][2];
     static uint64_t zobristSide;
-    // The current position's Zobrist hash key.  It is maintained
-    // incrementally in makeMove/unmakeMove.
-    uint64_t hashKey;
+    // For each cell and player, the table entries of the cell's images
+    // under the eight symmetries, so that a stone updates all symmetric
+    // keys with one contiguous row.
+    static uint64_t symmetricZobrist[144][2][NUM_SYMMETRIES];
+    // The current position's Zobrist keys under each symmetry; entry 0 is
+    // the hash key.  They are maintained incrementally in
+    // makeMove/unmakeMove.
+    uint64_t symmetricKeys[NUM_SYMMETRIES];
+    // XOR a stone of player p on cell idx, or the side marker, into every
+    // symmetric key.
+    void toggleStoneKeys(int idx, int p);
+    void toggleSideKeys();
 
     // Initialize Zobrist tables with random numbers.  Called lazily by the
     // constructor to ensure proper seeding.
@@ -5,7 +5,8 @@
 // a particular board coordinate has been responsible for a cutoff during
 // alpha–beta search.  Moves with larger history values are favoured in
 // subsequent move orderings.  The table is reset at the start of each
-// iterative deepening search.
+// iterative deepening search, or scaled down when the engine carries
+// history over between moves.
 
 #ifndef GOMOKU_HISTORY_HEURISTIC_H
 #define GOMOKU_HISTORY_HEURISTIC_H
@@ -20,6 +21,9 @@ public:
     HistoryHeuristic();
     // Reset the history table to zero for a new search.
     void reset();
+    // Divide every history value by divisor (values below divisor become
+    // zero).  Used to carry a weakened table over to the next search.
+    void scaleDown(int divisor);
     // Increment the history value for move m by depth^2.  Depth should
     // correspond to the remaining depth in the search tree when the cutoff
     // occurred; deeper cutoffs receive a larger increment.
@@ -0,0 +1,79 @@
+// line_geometry.h
+// Compile-time tables of the lines of the 12×12 board.
+//
+// The board has 70 lines: 12 rows, 12 columns, 23 diagonals running
+// down-right (constant x - y) and 23 anti-diagonals running up-right
+// (constant x + y).  LINE_GEOMETRY lists the cells of every line in order
+// as cell indices y*12+x, and for every cell the line through it in each
+// of the four directions together with the cell's position along that
+// line.  The tables are computed by the compiler, so code that walks lines
+// reads cell lists instead of recomputing diagonal bounds.
+
+#ifndef GOMOKU_LINE_GEOMETRY_H
+#define GOMOKU_LINE_GEOMETRY_H
+
+namespace gomoku {
+
+const int NUM_LINES = 70;
+const int MAX_LINE_LENGTH = 12;
+
+// Line directions, in the order used by LineGeometry::lineOf.
+enum LineDirection {
+    LINE_ROW = 0,        // (1,0)
+    LINE_COLUMN = 1,     // (0,1)
+    LINE_DIAGONAL = 2,   // (1,1)
+    LINE_ANTI = 3        // (1,-1)
+};
+
+struct LineGeometry {
+    int length[NUM_LINES];
+    int cells[NUM_LINES][MAX_LINE_LENGTH];
+    int lineOf[144][4];
+    int posOf[144][4];
+};
+
+namespace detail {
+
+constexpr void addLineCell(LineGeometry &g, int line, int dir, int x, int y) {
+    int idx = y * 12 + x;
+    g.posOf[idx][dir] = g.length[line];
+    g.cells[line][g.length[line]++] = idx;
+    g.lineOf[idx][dir] = line;
+}
+
+constexpr LineGeometry makeLineGeometry() {
+    LineGeometry g{};
+    int line = 0;
+    for (int y = 0; y < 12; ++y, ++line) {
+        for (int x = 0; x < 12; ++x) addLineCell(g, line, LINE_ROW, x, y);
+    }
+    for (int x = 0; x < 12; ++x, ++line) {
+        for (int y = 0; y < 12; ++y) addLineCell(g, line, LINE_COLUMN, x, y);
+    }
+    // Diagonals by k = x - y, starting on the top or left edge.
+    for (int k = -11; k <= 11; ++k, ++line) {
+        int x = k > 0 ? k : 0;
+        int y = k < 0 ? -k : 0;
+        for (; x < 12 && y < 12; ++x, ++y) addLineCell(g, line, LINE_DIAGONAL, x, y);
+    }
+    // Anti-diagonals by s = x + y, starting on the bottom or left edge.
+    for (int s = 0; s <= 22; ++s, ++line) {
+        int x = s > 11 ? s - 11 : 0;
+        int y = s < 11 ? s : 11;
+        for (; x < 12 && y >= 0; ++x, --y) addLineCell(g, line, LINE_ANTI, x, y);
+    }
+    return g;
+}
+
+} // namespace detail
+
+constexpr LineGeometry LINE_GEOMETRY = detail::makeLineGeometry();
+
+static_assert(LINE_GEOMETRY.length[0] == 12 && LINE_GEOMETRY.length[24] == 1 &&
+              LINE_GEOMETRY.length[35] == 12 && LINE_GEOMETRY.length[69] == 1,
+              "unexpected line lengths");
+static_assert(LINE_GEOMETRY.lineOf[143][LINE_ANTI] == 69, "unexpected line order");
+
+} // namespace gomoku
+
+#endif // GOMOKU_LINE_GEOMETRY_H
@@ -0,0 +1,54 @@
+// move_list.h
+// Fixed-capacity lists used by the search to avoid heap allocation.
+//
+// A 12×12 board has at most 144 empty cells, so every list of moves the
+// engine builds fits in a fixed array of 144 entries.  FixedList stores its
+// elements inline and never allocates; the search keeps one set of lists per
+// ply in an arena owned by SearchEngine and reuses them on every node.
+
+#ifndef GOMOKU_MOVE_LIST_H
+#define GOMOKU_MOVE_LIST_H
+
+#include <cassert>
+
+#include "board.h"
+
+namespace gomoku {
+
+// Maximum number of moves in any position.
+const int MAX_MOVES = 144;
+
+template <typename T, int Capacity>
+class FixedList {
+public:
+    FixedList() : count(0) {}
+
+    void clear() { count = 0; }
+    void push_back(const T &value) {
+        assert(count < Capacity);
+        items[count++] = value;
+    }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T &operator[](int i) { return items[i]; }
+    const T &operator[](int i) const { return items[i]; }
+    T &front() { return items[0]; }
+    const T &front() const { return items[0]; }
+
+    T *begin() { return items; }
+    T *end() { return items + count; }
+    const T *begin() const { return items; }
+    const T *end() const { return items + count; }
+
+private:
+    T items[Capacity];
+    int count;
+};
+
+typedef FixedList<Move, MAX_MOVES> MoveList;
+
+} // namespace gomoku
+
+#endif // GOMOKU_MOVE_LIST_H
@@ -0,0 +1,156 @@
+// network_eval.h
+// Quantised neural network evaluation with incrementally updated inputs.
+//
+// The network sees the board as 288 binary inputs per perspective: for
+// each of the 144 cells, "own stone here" and "opponent stone here",
+// where "own" is the perspective's colour.  Its first layer is a 288 x 64
+// matrix of int16 weights, so the first layer's output for a position is
+// the bias plus one weight row per stone.  Board keeps that sum, the
+// accumulator, for both perspectives and updates it by adding or
+// subtracting one row per perspective whenever a stone is placed or
+// removed; evaluating a position never looks at the stones.
+//
+// Evaluation clips the side to move's accumulator and the opponent's to
+// [0, 127] and concatenates them into 128 uint8 values, then applies a
+// 128 -> 32 layer of int8 weights (clipped to [0, 127] after a shift) and
+// a 32 -> 1 output layer of int8 weights.  The output is the network's
+// estimate of the side to move's winning chances as a logistic score,
+// converted to evaluation units with NETWORK_EVAL_SCALE.  Both the
+// accumulator updates and the hidden layers have an AVX2 kernel, chosen
+// at run time when the CPU supports it, and a portable scalar kernel;
+// they compute identical results.
+//
+// A weights file is a 16-byte header, magic "GMKNNUE\0" (8 bytes),
+// format version (uint32) and the size of the weights (uint32), followed
+// by NetworkWeights exactly as laid out below.  The file is memory-mapped
+// and used in place, so, like an opening book, it is in the byte order of
+// the machine that wrote it; a file of the other byte order is rejected
+// by open(), since its version and size fields do not match.  The
+// NetworkSample files that the tournament runner's --dump writes and
+// tests/network_train.cpp trains from are raw structs in host byte order
+// too, with no header to check.
+
+#ifndef GOMOKU_NETWORK_EVAL_H
+#define GOMOKU_NETWORK_EVAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gomoku {
+
+const int NETWORK_INPUTS = 288;
+const int NETWORK_HIDDEN = 64;    // first layer outputs per perspective
+const int NETWORK_L2 = 32;
+
+// Quantisation: first layer values are scaled by NETWORK_FT_SCALE (so an
+// activation of 1.0 is 127), hidden weights by NETWORK_L2_SCALE and
+// output weights by NETWORK_OUT_SCALE.  The hidden layer's int32 sums
+// are shifted right by NETWORK_L2_SHIFT to return to the activation scale.
+const int NETWORK_FT_SCALE = 127;
+const int NETWORK_L2_SCALE = 64;
+const int NETWORK_L2_SHIFT = 6;
+const int NETWORK_OUT_SCALE = 16;
+// Evaluation units per unit of network output.  A logistic score of 1
+// (about a 73% chance of winning) is worth a little less than a live
+// three in the pattern evaluation.
+const int NETWORK_EVAL_SCALE = 30000;
+// Network evaluations are clamped to this magnitude, far below any score
+// the search reserves for wins.
+const int NETWORK_EVAL_MAX = 10000000;
+
+// Input index of a stone of colour owner (0 black, 1 white) on cell
+// (y*12+x), seen from perspective (0 black, 1 white).
+inline int networkFeature(int perspective, int owner, int cell) {
+    return (owner == perspective ? 0 : 144) + cell;
+}
+
+struct NetworkWeights {
+    int16_t ftBias[NETWORK_HIDDEN];
+    int16_t ftWeights[NETWORK_INPUTS][NETWORK_HIDDEN];
+    int32_t l2Bias[NETWORK_L2];
+    int8_t l2Weights[NETWORK_L2][2 * NETWORK_HIDDEN];
+    int32_t outBias;
+    int8_t outWeights[NETWORK_L2];
+};
+
+// A position for training, as written by the tournament runner's --dump
+// and read by tests/network_train.cpp.
+struct NetworkSample {
+    // Stones of each colour (0 black, 1 white): cell y*12+x is bit
+    // cell % 64 of word cell / 64.
+    uint64_t stones[2][3];
+    // Score of the search from this position for the side to move.
+    int32_t score;
+    // Side to move (0 black, 1 white).
+    int8_t side;
+    // Outcome of the game for the side to move: 1 win, 0 draw, -1 loss.
+    int8_t result;
+    // Number of stones on the board.
+    int16_t ply;
+};
+static_assert(sizeof(NetworkSample) == 56, "unexpected network sample size");
+
+// The first layer output for each perspective.
+struct NetworkAccumulator {
+    int16_t values[2][NETWORK_HIDDEN];
+};
+
+enum class NetworkKernel {
+    Auto,     // AVX2 if available
+    Scalar,
+    Avx2      // falls back to scalar if unavailable
+};
+
+// True if the AVX2 kernel was compiled in and the CPU supports it.
+bool networkAvx2Available();
+
+class Network {
+public:
+    static const uint32_t FORMAT_VERSION = 1;
+
+    Network();
+    ~Network();
+    Network(const Network &) = delete;
+    Network &operator=(const Network &) = delete;
+
+    // Map the weights file at path, replacing any network already loaded.
+    // Returns false, leaving no network loaded, if the file cannot be read
+    // or is not a weights file of this format version.
+    bool open(const std::string &path);
+    // Use a copy of weights held in memory.
+    void assign(const NetworkWeights &weights);
+    void close();
+    bool isOpen() const { return weights != nullptr; }
+
+    void setKernel(NetworkKernel kernel);
+
+    // Write weights to path as a weights file.  Returns false if the file
+    // cannot be written.
+    static bool write(const std::string &path, const NetworkWeights &weights);
+
+    // Set acc to the first layer output for the stones in cells (codes as
+    // returned by Board::getCellState, indexed y*12+x).
+    void refresh(NetworkAccumulator &acc, const int8_t *cells) const;
+    // Add or remove a stone of colour owner on cell.
+    void addStone(NetworkAccumulator &acc, int cell, int owner) const;
+    void removeStone(NetworkAccumulator &acc, int cell, int owner) const;
+
+    // Evaluation for the side to move, side (0 black, 1 white), in
+    // evaluation units.
+    int evaluate(const NetworkAccumulator &acc, int side) const;
+
+private:
+    const NetworkWeights *weights;
+    bool useAvx2;
+    // The mapping (or, where mmap is unavailable or assign() was used,
+    // the copy in memory) backing weights.
+    void *mapping;
+    std::size_t mappingSize;
+    std::vector<unsigned char> buffer;
+};
+
+} // namespace gomoku
+
+#endif // GOMOKU_NETWORK_EVAL_H
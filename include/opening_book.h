@@ -0,0 +1,95 @@
+// opening_book.h
+// Read-only opening book mapped from a binary file.
+//
+// A book file is a 16-byte header followed by fixed-size records sorted by
+// position key:
+//
+//   header:  magic "GMKBOOK\0" (8 bytes), format version (uint32),
+//            record count (uint32)
+//   record:  key (uint64), move (uint16, cell index y*12+x),
+//            weight (uint16), score (int32)
+//
+// The key is Board::canonicalKey() of the position before the move, so
+// it includes the side to move and is shared by the position's mirror
+// images and rotations, and the move is given in the frame of the
+// canonical image.  A lookup maps it back through the inverse symmetry,
+// so one record serves every symmetric position.  A position may have
+// several records, one per book move; records with the same key are
+// stored by decreasing weight.  The file is memory-mapped and searched in
+// place, so opening a book costs one mmap and a lookup one binary search,
+// with no parsing.  tests/book_gen.cpp writes book files.
+//
+// Fields are in the byte order of the machine that wrote the file: the
+// header and records are written as they are laid out in memory and used
+// in place, without conversion.  A file written on a machine of the other
+// byte order is rejected by open(), since its version field does not read
+// as FORMAT_VERSION.
+
+#ifndef GOMOKU_OPENING_BOOK_H
+#define GOMOKU_OPENING_BOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board.h"
+
+namespace gomoku {
+
+struct BookRecord {
+    uint64_t key;
+    uint16_t move;
+    uint16_t weight;
+    int32_t score;
+};
+static_assert(sizeof(BookRecord) == 16, "book records must be 16 bytes");
+
+class OpeningBook {
+public:
+    static const uint32_t FORMAT_VERSION = 2;
+
+    // The record for playing m on board, keyed and oriented canonically.
+    static BookRecord makeRecord(const Board &board, const Move &m, int weight, int score);
+
+    OpeningBook();
+    ~OpeningBook();
+    OpeningBook(const OpeningBook &) = delete;
+    OpeningBook &operator=(const OpeningBook &) = delete;
+
+    // Map the book file at path, replacing any book already open.  Returns
+    // false, leaving the book empty, if the file cannot be read or is not
+    // a valid book of this format version.
+    bool open(const std::string &path);
+    void close();
+
+    bool isOpen() const { return records != nullptr; }
+    std::size_t size() const { return count; }
+
+    // The book move of highest weight for board's position that is an
+    // empty cell of board.  Returns false if the book has none.
+    bool probe(const Board &board, Move &move) const;
+
+    // All records stored for key, as a range of the mapped file.  Returns
+    // the number of records and points first at the first one.
+    std::size_t find(uint64_t key, const BookRecord *&first) const;
+
+    // Write records to path as a book file.  Records with the same key and
+    // move are merged, adding their weights (saturating) and keeping the
+    // score of the heaviest; the result is sorted as open() expects.
+    // Returns false if the file cannot be written.
+    static bool write(const std::string &path, std::vector<BookRecord> records);
+
+private:
+    const BookRecord *records;
+    std::size_t count;
+    // The mapping (or, where mmap is unavailable, the copy in memory)
+    // backing records.
+    void *mapping;
+    std::size_t mappingSize;
+    std::vector<unsigned char> buffer;
+};
+
+} // namespace gomoku
+
+#endif // GOMOKU_OPENING_BOOK_H
@@ -0,0 +1,69 @@
+// pattern_eval.h
+// Line pattern scoring for the Gomoku evaluation function.
+//
+// The evaluation credits every straight run of a player's stones along a
+// line (row, column or diagonal) according to its length and the number of
+// open ends, and every pair of runs split by a single gap.  Because a
+// line's score depends only on the cells of that line, every possible line
+// is scored once into a table indexed by a base-3 line code; the Board
+// keeps the code of each line for each player and looks up the four lines
+// through a cell whenever a stone is placed or removed.
+
+#ifndef GOMOKU_PATTERN_EVAL_H
+#define GOMOKU_PATTERN_EVAL_H
+
+#include <cstdint>
+
+namespace gomoku {
+
+// Threat weights.  Larger values correspond to stronger threats.
+const int SCORE_FIVE         = 100000000;
+const int SCORE_OPEN_FOUR    = 10000000;
+const int SCORE_SIMPLE_FOUR  = 1000000;
+const int SCORE_OPEN_THREE   = 100000;
+const int SCORE_BROKEN_THREE = 10000;
+const int SCORE_OPEN_TWO     = 1000;
+const int SCORE_CLOSED_TWO   = 100;
+
+// Score of a contiguous run of count stones.  leftOpen/rightOpen tell
+// whether the cell just beyond each end of the run is empty.
+int patternScore(int count, bool leftOpen, bool rightOpen);
+
+// Score of a gapped shape: two runs of own stones separated by one empty
+// cell, stones in total.  leftOpen/rightOpen describe the cells beyond the
+// outer ends of the two runs.
+int gapScore(int stones, bool leftOpen, bool rightOpen);
+
+// Score every run of own stones in a line.  states holds length cell
+// codes as returned by Board::getCellState (0 empty, 1 black, 2 white);
+// own is the code of the scored player.  Straight runs are scored by
+// patternScore and gapped shapes such as "xx.x" or "xx.xx" additionally by
+// gapScore.
+int scoreLine(const int8_t *states, int length, int own);
+
+// --- Line codes ---
+// A line of up to LINE_CODE_CELLS cells in base 3, cell i contributing
+// digit * 3^i: 0 = empty, 1 = a stone of the scored player, 2 = a stone of
+// the opponent.  Cells beyond the end of a shorter line are digit 2, since
+// the edge of the board closes a pattern just like an opponent stone.
+// Placing or removing a stone changes one digit, so a line's code can be
+// kept up to date with one addition per move.
+const int LINE_CODE_CELLS = 12;
+const int NUM_LINE_CODES = 531441;   // 3^12
+
+// Weight of cell i in a line code.
+inline int lineCodeWeight(int i) {
+    static const int WEIGHTS[LINE_CODE_CELLS] = {
+        1, 3, 9, 27, 81, 243, 729, 2187, 6561, 19683, 59049, 177147};
+    return WEIGHTS[i];
+}
+
+// scoreLine() of the line with the given code, read from a table that is
+// built once at startup.
+int lineCodeScore(int code);
+// The whole table, NUM_LINE_CODES entries, for batched lookups.
+const int *lineCodeScores();
+
+} // namespace gomoku
+
+#endif // GOMOKU_PATTERN_EVAL_H
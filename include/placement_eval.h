@@ -0,0 +1,37 @@
+// placement_eval.h
+// Batched evaluation of candidate moves.
+//
+// Placing a stone changes exactly four line codes (see pattern_eval.h): the
+// lines through the cell gain digit 1 in the mover's codes and digit 2 in
+// the opponent's.  The change in evaluation is therefore a sum of eight
+// table differences that can be computed for a whole list of candidate
+// cells without touching the board.  scorePlacements does this for many
+// candidates at once: an AVX2 kernel handles eight candidates per step with
+// gathers, and a portable scalar kernel is used when the CPU (detected at
+// run time) or the compiler does not support AVX2, or when it measures
+// faster than the gathers.
+
+#ifndef GOMOKU_PLACEMENT_EVAL_H
+#define GOMOKU_PLACEMENT_EVAL_H
+
+namespace gomoku {
+
+enum class PlacementKernel {
+    Auto,     // whichever of the two is faster on this CPU
+    Scalar,
+    Avx2      // falls back to scalar if unavailable
+};
+
+// True if the AVX2 kernel was compiled in and the CPU supports it.
+bool placementAvx2Available();
+
+// For each of the count cell indices cells[i] (y*12+x, all empty), write
+// to delta[i] the change in (lineScore(p) - lineScore(opponent)) caused
+// by a stone of player p (0 = black, 1 = white) on that cell.  lineCodes
+// holds the board's line codes as [line][player].
+void scorePlacements(const int *lineCodes, int p, const int *cells, int count,
+                     int *delta, PlacementKernel kernel = PlacementKernel::Auto);
+
+} // namespace gomoku
+
+#endif // GOMOKU_PLACEMENT_EVAL_H
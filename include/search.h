@@ -5,23 +5,117 @@
 #define GOMOKU_SEARCH_H
 
 #include "board.h"
+#include "move_list.h"
+#include "opening_book.h"
+#include "search_stats.h"
 #include "threat_solver.h"
+#include "threat_space.h"
+#include "time_manager.h"
+#include "transposition_table.h"
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
 #include <vector>
-#include <unordered_map>
 
 #include "history_heuristic.h"
 
 namespace gomoku {
 
-// A naive search engine that chooses a reasonable move.
-// For demonstration purposes, this implementation selects the legal move
-// closest to the center of the board.  In a real engine this class
-// would implement a proper game‑tree search.
+// Static evaluation used at the leaves of the search.
+enum class Evaluator {
+    Pattern,   // line pattern scores (pattern_eval.h)
+    Network    // quantised network (network_eval.h)
+};
+
+// Tunable engine settings.  The defaults match the competition setup.
+struct SearchConfig {
+    // Size of the transposition table in megabytes.
+    std::size_t ttSizeMb = 16;
+    // Keep transposition table entries from one move to the next.  Older
+    // entries are aged by a generation counter rather than erased, so the
+    // next search starts with the results of the previous one.
+    bool persistentTT = true;
+    // Carry history heuristic values over between moves instead of
+    // resetting them.  Carried values are divided by historyDecay so that
+    // cutoffs from the current search quickly dominate.
+    bool keepHistory = false;
+    int historyDecay = 4;
+    // Number of search threads.  Values above one enable Lazy SMP: helper
+    // threads run their own iterative deepening on the same root, starting
+    // at staggered depths, and share results through the transposition
+    // table.  Only the main thread's result is played.
+    int threads = 1;
+    // Search later moves of every node with a null window first (principal
+    // variation search) and use aspiration windows at the root.  When
+    // false, every move is searched with the node's full window.
+    bool pvs = true;
+    // Stop iterative deepening after this depth; 0 means no limit other
+    // than time.  Used for fixed-depth comparisons.
+    int maxDepth = 0;
+    // Stop the search once the main thread has visited this many nodes; 0
+    // means no limit.  The count is checked where the clock is polled, so
+    // a search stops at the same node on every run and machine.
+    uint64_t maxNodes = 0;
+    // Let the TimeManager stop iterative deepening before the time limit
+    // when the next iteration cannot finish its first move, the best move
+    // is stable or the position is forced.  When false, iterations are
+    // started until the time limit.
+    bool adaptiveTime = true;
+    // Hard cap on the time of one search in milliseconds; 0 makes the time
+    // limit given to findBestMove the cap.  It is checked at the next
+    // clock poll, so a search can overrun it by one polling interval.
+    // The TimeManager aims below the limit and extends an unsettled search
+    // towards the cap (see time_manager.h), so with a cap above the limit
+    // it may go beyond the limit.  A cap below the limit lowers the limit,
+    // for ponder searches too.
+    int moveTimeCapMs = 0;
+    // Look for forced wins by threats (see threat_space.h): VCF and VCT at
+    // the root before the main search, and a short VCF at the leaves.
+    bool threatSpace = true;
+    // At the horizon, extend forcing moves (fours, and in the first
+    // quiescence ply live threes and blocks of the opponent's) instead of
+    // evaluating a position where a threat is pending.
+    bool quiescence = true;
+    // Search late quiet moves at reduced depth and search them again at
+    // full depth if they beat alpha (late move reductions).  Only used
+    // with pvs, whose null-window searches the reduced searches are.
+    bool lateMoveReductions = true;
+    // At a remaining depth of at most this many plies, quiet moves beyond
+    // a depth-dependent count are not searched at all (move-count
+    // pruning); 0 disables it.
+    int moveCountPruningDepth = 2;
+    // Key the transposition table by Board::canonicalKey(), so that mirror
+    // images and rotations of a position share one entry.  Best moves are
+    // stored in the canonical frame and mapped back on lookup.
+    bool symmetricTT = false;
+    // Opening book file (see opening_book.h) consulted before searching;
+    // empty for none.  A missing or invalid file is ignored.
+    std::string bookPath;
+    // Leaf evaluation.  Move ordering and the threat searches use the
+    // pattern scores with either.  Evaluator::Network needs networkPath,
+    // a weights file (see network_eval.h); if it cannot be loaded the
+    // engine evaluates with patterns.
+    Evaluator evaluator = Evaluator::Pattern;
+    std::string networkPath;
+};
+
+// The game-tree search.  findBestMove answers from the opening book when
+// it can, then looks for a forced win by threats at the root, then runs
+// iterative deepening with aspiration windows over a negamax principal
+// variation search.  Interior nodes take their moves from a staged picker
+// (hash move, tactical moves, killers, then quiet moves by placement
+// score and history), reduce late quiet moves, and end in a quiescence
+// search of forcing moves.  Results are stored in a transposition table
+// that Lazy SMP helper threads share, and a TimeManager decides when to
+// stop deepening.  See SearchConfig for the options.
 class SearchEngine {
 public:
-    SearchEngine();
+    explicit SearchEngine(const SearchConfig &config = SearchConfig());
     // Return the next move for the given board and player using an
     // iterative deepening alpha–beta search.  The search respects a time
     // limit in milliseconds (default 2000ms).  The board is passed by
@@ -32,50 +126,217 @@ public:
     // Determine whether an opening move applies to the current position.
     // If an opening move exists for the player myColor, this function
     // assigns it to outMove and returns true.  Otherwise it returns false.
+    // The opening book is consulted first, then a built-in first move for
+    // Black.
     bool getOpeningMove(const Board &board, Player myColor, Move &outMove) const;
 
+    // Number of nodes visited by the last findBestMove call, summed over
+    // all search threads.
+    uint64_t nodesSearched() const;
+
+    // Statistics of the last findBestMove call (see search_stats.h).
+    const SearchStats &lastSearchStats() const { return lastStats; }
+
+    // --- Control of a running search from another thread ---
+    // Ask findBestMove to finish as soon as possible.  The search notices
+    // within TIME_CHECK_NODES nodes and returns the best move of its last
+    // completed iteration, or (-1,-1) if none completed.  The request
+    // stays in effect, so that it also stops a search that has not started
+    // yet, until resetStop().
+    void stop() { stopRequest.store(true, std::memory_order_relaxed); }
+    // Shorten the running search's time limit to timeLimitMs from now,
+    // with the hard cap that limit gets (see moveTimeCapMs).  A ponder
+    // search started with a long limit becomes the real search this way.
+    // Like stop(), it lasts until resetStop().
+    void setDeadline(int timeLimitMs);
+    // Withdraw stop() and setDeadline().  Call it before starting a search
+    // that another thread may stop.
+    void resetStop();
+
+    // The best move the transposition table holds for board's position,
+    // if it is a legal candidate; used to guess the opponent's reply.
+    bool expectedMove(const Board &board, Move &out) const;
+    // The principal variation from board's position: the chain of best
+    // moves the transposition table holds, followed until a position has
+    // none that is a legal candidate or a player has five.
+    void principalVariation(const Board &board, MoveList &out) const;
+
 private:
-    // Time management helpers.
+    // Construct a Lazy SMP helper that searches with the main engine's
+    // table and stops when stop becomes true.
+    SearchEngine(const SearchConfig &config, TranspositionTable &sharedTable,
+                 const std::atomic<bool> &stop);
+
+    // Body of findBestMove, without the statistics bookkeeping.
+    Move chooseMove(Board &board, Player myColor, int timeLimitMs);
+    // Iterative deepening from firstDepth until timeUp(); returns the best
+    // move of the last completed iteration.
+    Move iterativeDeepening(Board &board, Player myColor, int firstDepth);
+    // Search every root move to depth within [alpha, beta] for Us, the
+    // side to move at the root, recording each move's score in rootScores.
+    // bestOut receives the best move found, and bestExact whether its score
+    // was established inside the window, so that it can be trusted even if
+    // the rest of the iteration is cut short.
+    template <Player Us>
+    int searchRoot(Board &board, int depth, int alpha, int beta, Move &bestOut,
+                   bool &bestExact);
+    // Body of a helper thread: search a private copy of the root position.
+    void runHelper(Board board, Player myColor, int helperIndex);
+    // Mark all killer moves as invalid.
+    void clearKillers();
+
+    // Transposition table key of board's position, and the symmetry that
+    // maps its moves into the frame of the stored best move (0 unless
+    // config.symmetricTT is set).
+    uint64_t tableKey(const Board &board, int &symmetry) const;
+
+    // Time management helpers.  timeUp() only reads the result of the
+    // last pollStop(), which the search calls every TIME_CHECK_NODES nodes
+    // and once per root move, so the clock and the shared flags are not
+    // read at every node.
     void startTimer(int timeLimitMs);
-    bool timeUp() const;
+    // The hard cap of a move given timeLimitMs (see moveTimeCapMs).
+    int capFor(int timeLimitMs) const {
+        return config.moveTimeCapMs > 0 ? config.moveTimeCapMs : timeLimitMs;
+    }
+    bool timeUp() const { return stopping; }
+    void pollStop();
+
+    // The search kernels are templated on Us, the side to move, so that
+    // every colour-dependent index and comparison in them is a constant
+    // and each colour gets its own branch-free copy.  A node for Us
+    // recurses into the node for opponentOf(Us).
+    //
+    // Evaluation of the board from the perspective of Us.
+    template <Player Us>
+    int evaluate(const Board &board) const;
 
-    // Evaluation of the board from the perspective of myColor.
-    int evaluate(const Board &board, Player myColor) const;
-    int evaluatePlayer(const Board &board, Player player) const;
-    int patternScore(int count, bool leftOpen, bool rightOpen) const;
+    // Negamax alpha–beta search; the score is from Us's view.
+    template <Player Us>
+    int alphaBeta(Board &board, int depth, int alpha, int beta, int ply);
 
-    // Alpha–beta search.
-    int alphaBeta(Board &board, int depth, int alpha, int beta,
-                  Player currentPlayer, Player myColor, int ply);
+    // Quiescence search below the horizon, qply plies deep: the side to
+    // move may stand pat on the static evaluation or play a forcing move,
+    // and must block a four.  Spends at most qsBudget nodes per leaf.
+    template <Player Us>
+    int quiescence(Board &board, int alpha, int beta, int ply, int qply);
 
-    // Generate and sort candidate moves.  Sorting is based on a simple
-    // heuristic that prioritizes moves that yield immediate wins or
-    // block the opponent's winning opportunities.
-    std::vector<Move> orderMoves(Board &board, Player currentPlayer, Player myColor, int ply);
+    // Generate and sort the root's candidate moves into ordered.  Sorting
+    // is based on a simple heuristic that prioritizes moves that yield
+    // immediate wins or block the opponent's winning opportunities.
+    void orderMoves(Board &board, Player currentPlayer, Player myColor, int ply,
+                    MoveList &ordered);
+
+    // Fill out with the board's candidate moves without allocating.
+    void generateCandidates(const Board &board, MoveList &out) const;
+
+    // --- Staged move generation for interior nodes ---
+    // Moves are produced one at a time in stages, from most to least
+    // likely to cause a cutoff.  Stages that need scoring run only when
+    // reached, and quiet moves are picked by selection sort, so a node that
+    // cuts off early pays for little more than the moves it searched.
+    enum PickStage {
+        STAGE_HASH,          // best move stored in the transposition table
+        STAGE_TACTICAL_INIT,
+        STAGE_TACTICAL,      // immediate wins, then blocks of opponent fives
+        STAGE_KILLERS,       // killer moves of this ply
+        STAGE_QUIET_INIT,
+        STAGE_QUIET,         // everything else, by placement score, history and
+                             // threat severity
+        STAGE_DONE
+    };
+    struct MovePicker {
+        int stage;
+        int index;
+        Move ttMove;
+        Bitboard yielded;    // cells (y*12+x) already returned
+        // Set by the quiet stage: cells (bitIndex) where a move makes or
+        // blocks a four or live three, and the best history value among
+        // the quiet moves.  Used to choose reductions.
+        Bitboard forcing;
+        int historyMax;
+    };
+    // The picker of a node where Us is to move.
+    template <Player Us>
+    void initPicker(const Board &board, MovePicker &picker, const Move &ttMove);
+    // Produce the next move of the node at ply; returns false when done.
+    template <Player Us>
+    bool nextMove(Board &board, MovePicker &picker, int ply, Move &out);
+    // True if m is an empty cell among the board's candidate moves.
+    bool isCandidate(const Board &board, const Move &m) const;
 
-    // Timer end point.
+    // Timer end point (the hard cap), and the earlier end point set by
+    // setDeadline() as a steady_clock tick count (the maximum if none).
+    // Only the main engine reads the clock and the external requests, and
+    // raises helperStop when its search should end; helpers stop when they
+    // see the main engine's flag through sharedStop.  stopping is this
+    // thread's copy of the decision.
     std::chrono::steady_clock::time_point timeEnd;
-    // Maximum search depth reached during current search (for reporting).
-    int maxDepthReached;
+    std::atomic<int64_t> deadlineOverride;
+    std::atomic<int> deadlineOverrideMs;   // the limit it was set with
+    int64_t seenOverride;                  // last override passed to timeManager
+    std::atomic<bool> stopRequest;
+    std::atomic<bool> helperStop;
+    const std::atomic<bool> *sharedStop;
+    bool stopping;
+    static const int TIME_CHECK_NODES = 1024;   // a power of two
+    // Soft stopping decisions of the main engine; see time_manager.h.
+    TimeManager timeManager;
+    // Colour searched for by the previous findBestMove call.  History values
+    // are only carried over while it stays the same.
+    Player lastColor;
+    bool hasSearched;
 
     // Tactical threat detector used to surface urgent defensive moves, such as
     // blocking open threes or fours from the opponent.
     ThreatSolver threatSolver;
 
+    SearchConfig config;
+
+    // Opening book, opened from config.bookPath by the main engine.
+    OpeningBook book;
+
+    // Evaluation network, loaded from config.networkPath by the main
+    // engine and attached to the board for the duration of a search.
+    // Helpers evaluate with the network attached to their copy of the
+    // board.
+    Network network;
+
+    // Forced-win search.  Root searches get a budget of positions in
+    // proportion to the time limit (a solver position costs about a
+    // microsecond, so this is a few percent of the time), capped for long
+    // ponder searches; leaf checks get a small fixed budget.
+    ThreatSpaceSolver threatSpace;
+    static const int ROOT_VCF_MOVES = 12;
+    static const int ROOT_VCT_MOVES = 5;
+    static const int ROOT_THREAT_NODES_PER_MS = 40;
+    static const int ROOT_THREAT_MAX_NODES = 400000;
+    static const int LEAF_VCF_MOVES = 3;
+    static const int LEAF_VCF_NODES = 16;
+
+    // Quiescence limits: plies below the horizon, plies in which threes
+    // are extended as well as fours, and nodes per horizon leaf.
+    static const int QS_MAX_PLY = 8;
+    static const int QS_THREE_PLIES = 1;
+    static const int QS_MAX_NODES = 64;
+    int qsBudget = 0;
+
     // --- Transposition table ---
-    // Each entry stores the best known score for a position at a given depth,
-    // the depth at which it was computed, the type of bound (exact, lower,
-    // or upper), and the best move found.  The key is the Zobrist hash
-    // returned by Board::getHashKey().  Using a transposition table
-    // greatly reduces redundant computation by caching the results of
-    // previously evaluated positions.
-    struct TTEntry {
-        int depth;
-        int score;
-        int flag; // 0 = exact, 1 = lower bound, 2 = upper bound
-        Move bestMove;
-    };
-    std::unordered_map<uint64_t, TTEntry> transTable;
+    // Caches the score, bound type and best move of previously searched
+    // positions, keyed by the Zobrist hash returned by Board::getHashKey().
+    // The table is allocated once by the main engine; helpers refer to it
+    // and searching never allocates.
+    std::unique_ptr<TranspositionTable> ownTable;
+    TranspositionTable &transTable;
+
+    // Lazy SMP helper engines, created on first use.  Each has its own
+    // killer moves, history table and move arena.
+    std::vector<std::unique_ptr<SearchEngine>> helpers;
+
+    // Counters of this engine (this thread) in the current search, and
+    // the summary over all threads of the last completed call.
+    SearchStats stats;
+    SearchStats lastStats;
 
     // --- Killer move heuristics ---
     // Killer moves are moves that caused a beta cutoff at a given search ply.
@@ -85,9 +346,42 @@ private:
     static const int MAX_PLY = 64;
     Move killerMoves[MAX_PLY][2];
 
+    // --- Per-ply move arena ---
+    // Scratch lists for every ply of the search tree, allocated once with
+    // the engine.  A node at ply p only touches plyStack[p], so a whole
+    // findBestMove call runs without heap allocation.
+    struct ScoredMove {
+        int score;
+        Move move;
+    };
+    typedef FixedList<ScoredMove, MAX_MOVES> RootScores;
+    struct PlyBuffers {
+        MovePicker picker;
+        MoveList candidates;   // unordered candidates
+        FixedList<ScoredMove, MAX_MOVES> tactical;
+        FixedList<ScoredMove, MAX_MOVES> scored;
+        ThreatSolver::ThreatList threats;
+        int defensive[144];    // best blocking severity per cell
+        int cells[MAX_MOVES];      // candidate cell indices for batch scoring
+        int placement[MAX_MOVES];  // evaluation after each candidate
+    };
+    std::vector<PlyBuffers> plyStack;
+
+    // Score of a five completed at the root; wins found deeper score less.
+    static const int WIN_SCORE = 100000000;
+    // Widest possible search window is [-SCORE_MAX, SCORE_MAX], kept
+    // symmetric so that negating a bound never overflows.  The aspiration
+    // window starts at this half-width around the previous score.
+    static const int SCORE_MAX = std::numeric_limits<int>::max() - 1;
+    static const int ASPIRATION_WINDOW = 50000;
+
+    // Root move list, re-sorted between iterations, and its scores.
+    MoveList rootMoves;
+    RootScores rootScores;
+
     // History heuristic table.  Records how often moves cause cutoffs to
     // further improve move ordering.  It is reset at the start of each
-    // search.
+    // search unless SearchConfig::keepHistory is set.
     HistoryHeuristic history;
 };
 
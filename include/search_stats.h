@@ -0,0 +1,138 @@
+// search_stats.h
+// Counters describing what one findBestMove call did.
+//
+// SearchEngine fills a SearchStats for every move it chooses: how many
+// positions it visited and how fast, how deep it got, how well the
+// transposition table and move ordering worked, and where the time went.
+// The node and table counters are plain increments and always on.  The
+// time split between evaluation, move ordering and the threat solvers
+// comes from cycle counters read around those calls; reading the counter
+// costs more than evaluate() itself, so the timers are only compiled in
+// when GOMOKU_SEARCH_PROFILE is defined and read zero otherwise.
+
+#ifndef GOMOKU_SEARCH_STATS_H
+#define GOMOKU_SEARCH_STATS_H
+
+#include <cstdint>
+#include <ostream>
+
+#if defined(GOMOKU_SEARCH_PROFILE) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#elif defined(GOMOKU_SEARCH_PROFILE)
+#include <chrono>
+#endif
+
+namespace gomoku {
+
+struct SearchStats {
+    // Positions visited by the main search, and below its horizon by the
+    // quiescence search and the VCF/VCT solver (at the root and at the
+    // leaves), summed over all search threads.
+    uint64_t nodes = 0;
+    uint64_t qnodes = 0;
+    // Wall-clock time of the call in milliseconds.
+    double elapsedMs = 0.0;
+    // Last completed iteration and the deepest ply reached by the main
+    // thread, quiescence included.
+    int depth = 0;
+    int seldepth = 0;
+    // Score of the last completed iteration for the side that moved, from
+    // its point of view; the win score less the length of the win if the
+    // threat-space solver found one, and 0 if the move came from the book
+    // or answered an immediate threat without a search.
+    int score = 0;
+
+    // Transposition table probes, probes that found the position, and
+    // probes whose stored bound ended the node.
+    uint64_t ttProbes = 0;
+    uint64_t ttHits = 0;
+    uint64_t ttCutoffs = 0;
+
+    // Beta cutoffs, and those caused by the first move searched.
+    uint64_t cutoffs = 0;
+    uint64_t firstMoveCutoffs = 0;
+
+    // Cycles spent in leaf evaluation, in move ordering (orderMoves and
+    // the scoring stages of the move picker, including the blocking-move
+    // search they run), in ThreatSolver::findBlockingMoves, and in the
+    // VCF/VCT solver.  Time-stamp counter ticks on x86, nanoseconds
+    // elsewhere; zero unless built with GOMOKU_SEARCH_PROFILE.
+    uint64_t evalCycles = 0;
+    uint64_t orderCycles = 0;
+    uint64_t threatCycles = 0;
+    uint64_t threatSpaceCycles = 0;
+
+    // Nodes (including qnodes) per second.
+    double nps() const {
+        return elapsedMs > 0.0 ? (nodes + qnodes) * 1000.0 / elapsedMs : 0.0;
+    }
+    // Share of cutoffs found by the first move, in percent.
+    double firstMoveCutoffRate() const {
+        return cutoffs > 0 ? 100.0 * firstMoveCutoffs / cutoffs : 0.0;
+    }
+
+    // Add the counters of another thread's search.  Depths, score and time
+    // are left alone; they describe the main thread.
+    void accumulate(const SearchStats &other) {
+        nodes += other.nodes;
+        qnodes += other.qnodes;
+        ttProbes += other.ttProbes;
+        ttHits += other.ttHits;
+        ttCutoffs += other.ttCutoffs;
+        cutoffs += other.cutoffs;
+        firstMoveCutoffs += other.firstMoveCutoffs;
+        evalCycles += other.evalCycles;
+        orderCycles += other.orderCycles;
+        threatCycles += other.threatCycles;
+        threatSpaceCycles += other.threatSpaceCycles;
+    }
+};
+
+// One line of "name value" pairs, for logs.
+inline std::ostream &operator<<(std::ostream &os, const SearchStats &s) {
+    os << "depth " << s.depth << " seldepth " << s.seldepth << " score " << s.score
+       << " nodes " << s.nodes << " qnodes " << s.qnodes
+       << " time " << static_cast<uint64_t>(s.elapsedMs)
+       << " nps " << static_cast<uint64_t>(s.nps())
+       << " ttprobes " << s.ttProbes << " tthits " << s.ttHits
+       << " ttcutoffs " << s.ttCutoffs
+       << " cutoffs " << s.cutoffs
+       << " firstcut% " << static_cast<int>(s.firstMoveCutoffRate() + 0.5);
+#ifdef GOMOKU_SEARCH_PROFILE
+    os << " evalcycles " << s.evalCycles << " ordercycles " << s.orderCycles
+       << " threatcycles " << s.threatCycles
+       << " threatspacecycles " << s.threatSpaceCycles;
+#endif
+    return os;
+}
+
+// Adds the cycles between its construction and destruction to a counter.
+// An empty object unless GOMOKU_SEARCH_PROFILE is defined.
+class CycleTimer {
+public:
+#ifdef GOMOKU_SEARCH_PROFILE
+    explicit CycleTimer(uint64_t &counter) : counter(counter), start(now()) {}
+    ~CycleTimer() { counter += now() - start; }
+#else
+    explicit CycleTimer(uint64_t &) {}
+#endif
+    CycleTimer(const CycleTimer &) = delete;
+    CycleTimer &operator=(const CycleTimer &) = delete;
+
+private:
+#ifdef GOMOKU_SEARCH_PROFILE
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+    uint64_t &counter;
+    uint64_t start;
+#endif
+};
+
+} // namespace gomoku
+
+#endif // GOMOKU_SEARCH_STATS_H
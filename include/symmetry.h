@@ -0,0 +1,75 @@
+// symmetry.h
+// The eight symmetries of the square board.
+//
+// Symmetry t (0..7) maps a cell by transposing it if bit 0 of t is set,
+// then mirroring x (x -> 11 - x) if bit 1 is set and mirroring y if bit 2
+// is set.  Symmetry 0 is the identity.  The opening cross of Board()
+// (white on (5,5) and (6,6), black on (5,6) and (6,5)) is kept by four of
+// them: the identity, the transpose (1), the half turn (6) and the
+// anti-transpose (7).  The other four swap the colours of the cross, so
+// they never map a reachable position onto another reachable one; they
+// are still provided so that a position and all its images can be hashed
+// uniformly.  SYMMETRY is computed by the compiler.
+
+#ifndef GOMOKU_SYMMETRY_H
+#define GOMOKU_SYMMETRY_H
+
+namespace gomoku {
+
+const int NUM_SYMMETRIES = 8;
+
+// The symmetry that undoes t.  Mirrors are their own inverses; a
+// transposition turns a following x mirror into a preceding y mirror.
+constexpr int inverseSymmetry(int t) {
+    return (t & 1) ? (1 | ((t & 2) << 1) | ((t & 4) >> 1)) : t;
+}
+
+struct SymmetryTable {
+    // Image of cell index y*12+x under each symmetry.
+    int cellOf[NUM_SYMMETRIES][144];
+};
+
+namespace detail {
+
+constexpr int transformCell(int t, int idx) {
+    int x = idx % 12;
+    int y = idx / 12;
+    if (t & 1) {
+        int s = x;
+        x = y;
+        y = s;
+    }
+    if (t & 2) x = 11 - x;
+    if (t & 4) y = 11 - y;
+    return y * 12 + x;
+}
+
+constexpr SymmetryTable makeSymmetryTable() {
+    SymmetryTable s{};
+    for (int t = 0; t < NUM_SYMMETRIES; ++t) {
+        for (int idx = 0; idx < 144; ++idx) s.cellOf[t][idx] = transformCell(t, idx);
+    }
+    return s;
+}
+
+constexpr bool inversesHold(const SymmetryTable &s) {
+    for (int t = 0; t < NUM_SYMMETRIES; ++t) {
+        for (int idx = 0; idx < 144; ++idx) {
+            if (s.cellOf[inverseSymmetry(t)][s.cellOf[t][idx]] != idx) return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+constexpr SymmetryTable SYMMETRY = detail::makeSymmetryTable();
+
+static_assert(detail::inversesHold(SYMMETRY), "inverseSymmetry does not invert");
+static_assert(SYMMETRY.cellOf[6][5 * 12 + 5] == 6 * 12 + 6 &&
+              SYMMETRY.cellOf[7][5 * 12 + 6] == 5 * 12 + 6,
+              "symmetries 6 and 7 should keep the opening cross");
+
+} // namespace gomoku
+
+#endif // GOMOKU_SYMMETRY_H
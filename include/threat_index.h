@@ -0,0 +1,95 @@
+// threat_index.h
+// Incremental index of the five- and six-cell windows of the board.
+//
+// Every threat in Gomoku lives in a short window of a line: a four is a
+// five-cell window with four stones of one colour and none of the other,
+// a live three is a six-cell window with empty ends and three stones of
+// one colour among its four inner cells.  ThreatIndex keeps the number of
+// stones of each colour in every such window, and for each colour the set
+// of windows currently holding a three or a four.  Board updates it on
+// every makeMove/unmakeMove by touching only the windows through the
+// changed cell (at most 20 five-cell and 24 six-cell windows), so the
+// current threats of a colour are available without scanning the board.
+
+#ifndef GOMOKU_THREAT_INDEX_H
+#define GOMOKU_THREAT_INDEX_H
+
+#include <cstdint>
+
+#include "bitboard.h"
+
+namespace gomoku {
+
+class ThreatIndex {
+public:
+    static const int NUM_FIVES = 320;
+    static const int NUM_SIXES = 266;
+
+    // A set of window numbers.
+    struct WindowSet {
+        uint64_t w[5];
+
+        bool any() const { return (w[0] | w[1] | w[2] | w[3] | w[4]) != 0ULL; }
+        void set(int i) { w[i >> 6] |= 1ULL << (i & 63); }
+        void clear(int i) { w[i >> 6] &= ~(1ULL << (i & 63)); }
+
+        // Call f(window) for every window in ascending order.
+        template <typename F>
+        void forEach(F f) const {
+            for (int c = 0; c < 5; ++c) {
+                uint64_t word = w[c];
+                while (word) {
+                    f(c * 64 + lowestBit(word));
+                    word &= word - 1;
+                }
+            }
+        }
+    };
+
+    // The index of an empty board.
+    ThreatIndex();
+
+    // Record that a stone of player p (0 = black, 1 = white) was placed on
+    // or removed from cell idx = y*12+x.  place returns true if the stone
+    // completes five in a row.
+    bool place(int idx, int p);
+    void remove(int idx, int p);
+
+    // True if a stone of player p on the empty cell idx would complete
+    // five in a row.
+    bool completesFive(int idx, int p) const;
+
+    // Five-cell windows with no stone of the opponent of p and exactly n
+    // stones of p, for n = 3 or 4.
+    const WindowSet &fives(int p, int n) const { return fiveSets[p][n - 3]; }
+    // Six-cell windows with both end cells empty, no stone of the opponent
+    // of p and exactly n stones of p in the four inner cells, for n = 2
+    // or 3.
+    const WindowSet &sixes(int p, int n) const { return sixSets[p][n - 2]; }
+
+    // Geometry of five-cell window w: its cells as a mask in the layout of
+    // bitboard.h, and the cell indices along the line for i = 0..4.  i = -1
+    // and i = 5 give the cells just before and after the window, or -1
+    // where the line ends.
+    static const uint64_t *fiveMask(int w);
+    static int fiveCell(int w, int i);
+    // Masks of the four inner cells and the two end cells of six-cell
+    // window w.
+    static const uint64_t *sixInner(int w);
+    static const uint64_t *sixEnds(int w);
+
+private:
+    // Refresh the set memberships of one window from its counts.
+    void updateFive(int w);
+    void updateSix(int w);
+
+    uint8_t fiveCount[NUM_FIVES][2];
+    uint8_t sixInnerCount[NUM_SIXES][2];
+    uint8_t sixEndCount[NUM_SIXES][2];
+    WindowSet fiveSets[2][2];   // [player][n - 3]
+    WindowSet sixSets[2][2];    // [player][n - 2]
+};
+
+} // namespace gomoku
+
+#endif // GOMOKU_THREAT_INDEX_H
@@ -5,19 +5,18 @@
 // for five-in-a-row while denying the opponent open fours, open threes, and
 // broken threes. An "open" pattern keeps empty cells at both ends; a "broken"
 // three contains a single gap but can still produce an open four in one move.
-// By scanning every line (rows, columns, and both diagonals) and scoring
-// dangerous layouts, the solver proposes blocking moves that neutralize the
-// opponent's most urgent threats. This mirrors common defensive strategy in
-// Gomoku: stop imminent wins first, then close off flexible threes before they
-// blossom into lethal fours.
+// By scoring the dangerous five-cell windows of every line (rows, columns,
+// and both diagonals), the solver proposes blocking moves that neutralize the
+// opponent's most urgent threats. The windows come from the board's
+// ThreatIndex, so no line is rescanned. This mirrors common defensive
+// strategy in Gomoku: stop imminent wins first, then close off flexible
+// threes before they blossom into lethal fours.
 
 #ifndef GOMOKU_THREAT_SOLVER_H
 #define GOMOKU_THREAT_SOLVER_H
 
-#include <vector>
-#include <unordered_map>
-
 #include "board.h"
+#include "move_list.h"
 
 namespace gomoku {
 
@@ -31,28 +30,20 @@ public:
         Move move;
         int severity;
     };
+    typedef FixedList<ThreatMove, MAX_MOVES> ThreatList;
 
     // Identify blocking moves that defend against the opponent's tactical
     // threats. The defender argument indicates whose interests are protected;
     // the solver analyzes patterns belonging to the opponent of defender.
-    std::vector<ThreatMove> findBlockingMoves(const Board &board, Player defender) const;
+    // The moves are written to out, most severe first; out is cleared first.
+    void findBlockingMoves(const Board &board, Player defender, ThreatList &out) const;
 
 private:
-    struct LineContext {
-        int xStart;
-        int yStart;
-        int dx;
-        int dy;
-        int length;
-    };
-
-    // Convert the board to a 2D grid of ints: 1 for the attacking side, -1 for
-    // the defender, 0 for empty.
-    void buildGrid(const Board &board, Player defender, int grid[12][12]) const;
-    void processLine(const int grid[12][12], const LineContext &ctx,
-                     std::unordered_map<int, int> &bestSeverity) const;
-    void addMoveIfStronger(int x, int y, int severity,
-                           std::unordered_map<int, int> &bestSeverity) const;
+    // Severity of a five-cell window holding attackerStones (3 or 4)
+    // attacker stones and no defender stone; leftOpen/rightOpen tell
+    // whether the cells just beyond the window are empty.  0 means the
+    // window is no threat.
+    static int windowSeverity(int attackerStones, bool leftOpen, bool rightOpen);
 };
 
 } // namespace gomoku
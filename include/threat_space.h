@@ -0,0 +1,76 @@
+// threat_space.h
+// Threat-space search for forced wins.
+//
+// ThreatSolver answers the defensive question "which cells block the
+// opponent's threats?".  ThreatSpaceSolver asks the attacking one: can the
+// side to move force five in a row by threats alone?  It only ever plays
+// forcing moves, so its tree is narrow enough to reach wins many plies
+// beyond the horizon of the full-width search:
+//   * VCF (victory by continuous fours): every attacking move makes a four,
+//     and the defender's only reply is to block it;
+//   * VCT (victory by continuous threats): attacking moves may also make a
+//     live three.  The defender may then block any cell of the three or
+//     answer with a four of their own, and every such reply must lose.
+// Results are cached by Zobrist key in a small table of proofs (a win
+// within some number of attacking moves) and disproofs (no win within that
+// number); the solver keeps the table between calls.
+
+#ifndef GOMOKU_THREAT_SPACE_H
+#define GOMOKU_THREAT_SPACE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "board.h"
+
+namespace gomoku {
+
+class ThreatSpaceSolver {
+public:
+    // cacheBits selects a cache of 2^cacheBits entries.
+    explicit ThreatSpaceSolver(int cacheBits = 16);
+
+    // Look for a forced win for the side to move using at most maxMoves
+    // attacking moves and visiting at most maxNodes positions.  On success
+    // the first attacking move is written to move and the length of the
+    // win in plies to plies.  The board is restored before returning.
+    bool findVcf(Board &board, int maxMoves, int maxNodes, Move &move, int &plies);
+    bool findVct(Board &board, int maxMoves, int maxNodes, Move &move, int &plies);
+
+    // Forget all cached proofs and disproofs.
+    void clear();
+
+    // Positions visited by the last find call.
+    int nodesSearched() const { return nodes; }
+
+private:
+    enum Mode { VCF = 0, VCT = 1 };
+
+    bool find(Board &board, Mode mode, int maxMoves, int maxNodes, Move &move, int &plies);
+    // The attacker is to move with movesLeft attacking moves to spend.
+    // Returns true if a win is proven; plies receives its length.
+    bool attack(Board &board, Mode mode, int movesLeft, int &plies, Move *first);
+    // The defender is to move after an attacking move.
+    bool defend(Board &board, Mode mode, int movesLeft, int &plies);
+
+    struct CacheEntry {
+        uint64_t key;
+        int8_t moves;    // attacking moves the result was computed with
+        int8_t proven;   // 1 = win within moves, 0 = no win within moves
+        int8_t plies;    // length of a proven win
+    };
+    bool probe(uint64_t key, int movesLeft, bool &win, int &plies) const;
+    void store(uint64_t key, int movesLeft, bool win, int plies);
+
+    std::vector<CacheEntry> cache;
+    uint64_t cacheMask;
+    int nodes;
+    int nodeLimit;
+    // Set when the node limit cut the search short; disproofs found after
+    // that are incomplete and are not cached.
+    bool aborted;
+};
+
+} // namespace gomoku
+
+#endif // GOMOKU_THREAT_SPACE_H
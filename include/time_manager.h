@@ -0,0 +1,94 @@
+// time_manager.h
+// Decides when iterative deepening should stop starting new iterations.
+//
+// A search has two times.  The limit is what the caller gives the move;
+// the hard cap (SearchConfig::moveTimeCapMs, the limit itself by
+// default) is enforced by SearchEngine::pollStop().  The clock is only
+// read every TIME_CHECK_NODES nodes and the search then has to unwind,
+// so a search can overrun the cap by about one polling interval (a few
+// milliseconds).
+// Between them TimeManager keeps a soft target, which starts at
+// TARGET_SHARE of the limit, and decides after every completed iteration
+// whether the next one is worth starting:
+//
+//  * No iteration is started once the soft target has passed.
+//  * When the best move changed in the last iteration, or the score fell
+//    by more than SCORE_DROP, the target moves EXTEND_SHARE of the way
+//    to the hard cap, so an unsettled search gets more time, up to the
+//    cap.  None of the early stops below apply then.
+//  * It predicts the next iteration's duration from the last one and the
+//    effective branching factor (the ratio of the durations of the last
+//    two iterations).  The next iteration is only started if its first
+//    root move, which takes about FIRST_MOVE_SHARE of it, can finish
+//    before the hard cap; the engine keeps the result of an iteration
+//    that stopped after that.
+//  * When the best move has not changed for STABLE_ITERATIONS iterations,
+//    it stops once STABLE_SHARE of the limit has passed.
+//  * When the position is forced (a single urgent block), it stops once
+//    FORCED_SHARE of the limit has passed.
+//
+// The limit can be restarted while the search runs; a ponder search that
+// becomes the real search restarts it with the normal move time.
+
+#ifndef GOMOKU_TIME_MANAGER_H
+#define GOMOKU_TIME_MANAGER_H
+
+#include <chrono>
+
+#include "board.h"
+
+namespace gomoku {
+
+class TimeManager {
+public:
+    static const int STABLE_ITERATIONS = 5;
+    static constexpr double STABLE_SHARE = 0.5;
+    static constexpr double FORCED_SHARE = 0.1;
+    static constexpr double FIRST_MOVE_SHARE = 0.5;
+    static constexpr double TARGET_SHARE = 0.7;
+    static constexpr double EXTEND_SHARE = 0.5;
+    static const int SCORE_DROP = 50000;
+
+    TimeManager();
+
+    // Begin a search with a limit of limitMs milliseconds and a hard cap of
+    // capMs; a cap below the limit lowers the limit to it.
+    void start(int limitMs, int capMs);
+    // Give the search limitMs milliseconds from now, capped at capMs,
+    // keeping what has been learnt about iteration durations.
+    void restart(int limitMs, int capMs);
+    // Mark the root position as forced.
+    void setForced() { forced = true; }
+
+    // Record that an iteration finished with best move best and score
+    // score.
+    void iterationDone(const Move &best, int score);
+    // True if another iteration should be started.
+    bool startNextIteration() const;
+
+    // Milliseconds since start() or restart().
+    double elapsedMs() const;
+    // The current soft target in milliseconds since start() or restart().
+    double targetMs() const { return target; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point windowStart;
+    double limitMs;
+    double capMs;
+    double target;
+    Clock::time_point lastIteration;   // end of the previous iteration
+    double lastDurationMs;             // durations of the last two
+    double previousDurationMs;         // iterations, or 0
+    Move lastBest;
+    int lastScore;
+    int stableIterations;
+    bool bestChanged;
+    bool scoreDropped;
+    bool forced;
+};
+
+} // namespace gomoku
+
+#endif // GOMOKU_TIME_MANAGER_H
@@ -0,0 +1,104 @@
+// transposition_table.h
+// Fixed-size transposition table for the Gomoku search engine.
+//
+// The table is a preallocated, power-of-two array of buckets.  Each bucket
+// occupies exactly one 64-byte cache line and holds four entries, so a probe
+// touches a single line of memory and a store never allocates.  The low bits
+// of the Zobrist key select the bucket.  When a bucket is full, the entry
+// with the lowest worth (shallow depth, old search generation) is replaced.
+//
+// The table may be shared by several search threads without locks.  Each
+// entry is two 64-bit words: the packed data and the key XORed with the
+// data.  Both words are written and read with relaxed atomic operations; if
+// two threads race on the same slot and a reader sees one word from each
+// write, the XOR check fails and the entry simply reads as a miss.
+
+#ifndef GOMOKU_TRANSPOSITION_TABLE_H
+#define GOMOKU_TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "board.h"
+
+namespace gomoku {
+
+// Unpacked view of a transposition table entry.  It stores the best known
+// score for a position at a given depth, the depth at which it was computed,
+// the type of bound (exact, lower, or upper), and the best move found.
+struct TTEntry {
+    int depth;
+    int score;
+    int flag; // 0 = exact, 1 = lower bound, 2 = upper bound
+    Move bestMove;
+};
+
+class TranspositionTable {
+public:
+    // Allocate a table of roughly sizeMb megabytes.  The bucket count is
+    // rounded down to a power of two.
+    explicit TranspositionTable(std::size_t sizeMb = 16);
+
+    // Reallocate the table to roughly sizeMb megabytes.  All entries are
+    // lost.  This is the only operation that allocates memory.  Not safe
+    // while other threads use the table.
+    void resize(std::size_t sizeMb);
+
+    // Erase all entries without releasing the storage.  Not safe while
+    // other threads use the table.
+    void clear();
+
+    // Advance the search generation.  Entries written by earlier searches
+    // keep their data but are replaced in preference to current ones.
+    void newSearch();
+
+    // Look up key.  Returns true and fills out if a matching entry exists.
+    bool probe(uint64_t key, TTEntry &out) const;
+
+    // Store a search result for key.  flag uses the same encoding as
+    // TTEntry::flag.  A bestMove of (-1,-1) means no move is known; in that
+    // case a move already stored for the same position is preserved.
+    void store(uint64_t key, int depth, int score, int flag, const Move &bestMove);
+
+    // Size of the allocated table in bytes.
+    std::size_t sizeBytes() const { return bucketCount * sizeof(Bucket); }
+
+private:
+    // One slot: check = key ^ data.  data packs, from the low bits up:
+    // score (32 bits), move (8, cell index y*12+x or NO_MOVE), depth (8,
+    // signed), bound (8, flag + 1 with 0 marking an empty slot) and
+    // generation (8).
+    struct Entry {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    static const int BUCKET_ENTRIES = 4;
+    static const uint8_t NO_MOVE = 0xFF;
+
+    struct alignas(64) Bucket {
+        Entry entries[BUCKET_ENTRIES];
+    };
+    static_assert(sizeof(Bucket) == 64, "TT bucket must fill one cache line");
+
+    static uint64_t pack(int score, uint8_t move, int depth, int bound, uint8_t generation);
+    static int scoreOf(uint64_t data) { return static_cast<int32_t>(static_cast<uint32_t>(data)); }
+    static uint8_t moveOf(uint64_t data) { return static_cast<uint8_t>(data >> 32); }
+    static int depthOf(uint64_t data) { return static_cast<int8_t>(static_cast<uint8_t>(data >> 40)); }
+    static int boundOf(uint64_t data) { return static_cast<uint8_t>(data >> 48); }
+    static uint8_t generationOf(uint64_t data) { return static_cast<uint8_t>(data >> 56); }
+
+    Bucket &bucketFor(uint64_t key) { return buckets[key & bucketMask]; }
+    const Bucket &bucketFor(uint64_t key) const { return buckets[key & bucketMask]; }
+
+    std::unique_ptr<Bucket[]> buckets;
+    std::size_t bucketCount;
+    uint64_t bucketMask;
+    uint8_t generation;
+};
+
+} // namespace gomoku
+
+#endif // GOMOKU_TRANSPOSITION_TABLE_H
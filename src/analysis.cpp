@@ -0,0 +1,97 @@
+// analysis.cpp
+// Worker pool behind BatchAnalyzer and analyzeBatch.
+
+#include "analysis.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace gomoku {
+
+BatchAnalyzer::BatchAnalyzer(const AnalysisOptions &opts, ResultCallback callback)
+    : options(opts), onResult(std::move(callback)), closing(false) {
+    options.workers = std::max(1, options.workers);
+    SearchConfig config = options.config;
+    config.ttSizeMb = std::max<std::size_t>(1, config.ttSizeMb / options.workers);
+    config.persistentTT = false;
+    config.keepHistory = false;
+    for (int i = 0; i < options.workers; ++i) {
+        engines.emplace_back(new SearchEngine(config));
+    }
+    for (int i = 0; i < options.workers; ++i) {
+        threads.emplace_back(&BatchAnalyzer::work, this, std::ref(*engines[i]));
+    }
+}
+
+BatchAnalyzer::~BatchAnalyzer() {
+    finish();
+}
+
+void BatchAnalyzer::submit(uint64_t id, const Board &board) {
+    std::unique_lock<std::mutex> guard(queueLock);
+    spaceFree.wait(guard, [this]() {
+        return queue.size() < QUEUE_PER_WORKER * options.workers;
+    });
+    queue.push_back({id, board});
+    jobReady.notify_one();
+}
+
+void BatchAnalyzer::finish() {
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        closing = true;
+    }
+    jobReady.notify_all();
+    for (auto &t : threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+void BatchAnalyzer::work(SearchEngine &engine) {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> guard(queueLock);
+            jobReady.wait(guard, [this]() { return closing || !queue.empty(); });
+            if (queue.empty()) return;
+            job = queue.front();
+            queue.pop_front();
+        }
+        spaceFree.notify_one();
+
+        AnalysisResult result;
+        Board board = job.board;
+        result.move = engine.findBestMove(board, board.sideToMove(), options.timeLimitMs);
+        result.stats = engine.lastSearchStats();
+        result.score = result.stats.score;
+        // The line continues from the position after the chosen move: a
+        // book or threat-space answer leaves no table entry at the root.
+        if (result.move.x >= 0 && board.makeMove(result.move.x, result.move.y)) {
+            MoveList rest;
+            engine.principalVariation(board, rest);
+            result.pv.push_back(result.move);
+            for (int i = 0; i < rest.size() && result.pv.size() < MAX_MOVES; ++i) {
+                result.pv.push_back(rest[i]);
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(callbackLock);
+        onResult(job.id, result);
+    }
+}
+
+std::vector<AnalysisResult> analyzeBatch(const std::vector<Board> &positions,
+                                         const AnalysisOptions &options) {
+    std::vector<AnalysisResult> results(positions.size());
+    {
+        // Each callback writes its own slot.
+        BatchAnalyzer analyzer(options, [&results](uint64_t id, const AnalysisResult &r) {
+            results[id] = r;
+        });
+        for (std::size_t i = 0; i < positions.size(); ++i) analyzer.submit(i, positions[i]);
+        analyzer.finish();
+    }
+    return results;
+}
+
+} // namespace gomoku
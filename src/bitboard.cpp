@@ -0,0 +1,124 @@
+// bitboard.cpp
+// Direction masks and whole-board pattern operations for Bitboard.
+
+#include "bitboard.h"
+
+namespace gomoku {
+
+namespace {
+
+const int DIR_DX[NUM_DIRECTIONS] = {1, 0, 1, -1};
+const int DIR_DY[NUM_DIRECTIONS] = {0, 1, 1, 1};
+
+inline int strideOf(int dir) { return DIR_DY[dir] * BOARD_STRIDE + DIR_DX[dir]; }
+
+// Masks applied after a one-step shift.  A result cell is kept only if its
+// source cell is on the board; in the dense layout this removes the column
+// that received bits wrapped around from the neighbouring row.
+struct StepMasks {
+    Bitboard board;
+    Bitboard back[NUM_DIRECTIONS];
+    Bitboard forward[NUM_DIRECTIONS];
+
+    StepMasks() {
+        board = Bitboard::none();
+        for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+            back[dir] = Bitboard::none();
+            forward[dir] = Bitboard::none();
+        }
+        for (int y = 0; y < 12; ++y) {
+            for (int x = 0; x < 12; ++x) {
+                board.set(bitIndex(x, y));
+                for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+                    int bx = x + DIR_DX[dir], by = y + DIR_DY[dir];
+                    if (bx >= 0 && bx < 12 && by >= 0 && by < 12) back[dir].set(bitIndex(x, y));
+                    int fx = x - DIR_DX[dir], fy = y - DIR_DY[dir];
+                    if (fx >= 0 && fx < 12 && fy >= 0 && fy < 12) forward[dir].set(bitIndex(x, y));
+                }
+            }
+        }
+    }
+};
+
+const StepMasks stepMasks;
+
+} // unnamed namespace
+
+Bitboard boardMask() {
+    return stepMasks.board;
+}
+
+Bitboard stepBack(const Bitboard &b, int dir) {
+    return b.shiftDown(strideOf(dir)) & stepMasks.back[dir];
+}
+
+Bitboard stepForward(const Bitboard &b, int dir) {
+    return b.shiftUp(strideOf(dir)) & stepMasks.forward[dir];
+}
+
+// Cell (x,y) of the result is cell (x+k*dx, y+k*dy) of b.  Only valid when
+// the result is ANDed with a set that has no off-board bits: in the padded
+// layout the shift may leave stray bits in the padding column, but any chain
+// that crosses the padding picks up a zero there, so the whole k-step shift
+// is done at once.  The dense layout masks after every step instead.
+namespace {
+Bitboard chainBack(const Bitboard &b, int dir, int k) {
+#ifdef GOMOKU_PADDED_BITBOARD
+    return b.shiftDown(k * strideOf(dir));
+#else
+    Bitboard t = b;
+    for (int i = 0; i < k; ++i) t = stepBack(t, dir);
+    return t;
+#endif
+}
+} // unnamed namespace
+
+bool containsFive(const Bitboard &b) {
+    for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+#ifdef GOMOKU_PADDED_BITBOARD
+        Bitboard r = b & chainBack(b, dir, 1);
+        r = r & chainBack(r, dir, 2);
+        r = r & chainBack(b, dir, 4);
+#else
+        // Each masked step is reused for the next, so four steps suffice.
+        Bitboard r = b;
+        Bitboard t = b;
+        for (int k = 1; k < 5; ++k) {
+            t = stepBack(t, dir);
+            r = r & t;
+        }
+#endif
+        if (r.any()) return true;
+    }
+    return false;
+}
+
+Bitboard neighbourhood(const Bitboard &b) {
+    Bitboard r = Bitboard::none();
+    for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+        r = r | stepBack(b, dir) | stepForward(b, dir);
+    }
+    return r.andNot(b);
+}
+
+Bitboard openThreeStarts(const Bitboard &own, const Bitboard &empty) {
+    Bitboard r = Bitboard::none();
+    for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+        // Cell k steps ahead, for k = 1..4: own, own, own, empty.
+#ifdef GOMOKU_PADDED_BITBOARD
+        Bitboard o1 = chainBack(own, dir, 1);
+        Bitboard o2 = chainBack(own, dir, 2);
+        Bitboard o3 = chainBack(own, dir, 3);
+        Bitboard e4 = chainBack(empty, dir, 4);
+#else
+        Bitboard o1 = stepBack(own, dir);
+        Bitboard o2 = stepBack(o1, dir);
+        Bitboard o3 = stepBack(o2, dir);
+        Bitboard e4 = chainBack(empty, dir, 4);
+#endif
+        r = r | (empty & o1 & o2 & o3 & e4);
+    }
+    return r;
+}
+
+} // namespace gomoku
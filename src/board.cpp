@@ -1,4 +1,6 @@
 #include "board.h"
+#include "line_geometry.h"
+#include "pattern_eval.h"
 #include <cstring>
 #include <random>
 
@@ -6,25 +8,71 @@ namespace gomoku {
 
 // The Board implementation uses two bitboards (one for each player) split into three
 // 64‑bit chunks to cover all 144 squares of a 12×12 board.  A cell at
-// coordinate (x,y) has linear index idx = y*12 + x.  The high bits of idx
-// (idx >> 6) select which 64‑bit chunk stores that cell; the low bits
-// (idx & 63) select the bit within the chunk.  Each bitboard tracks only
+// coordinate (x,y) is stored at bit b = bitIndex(x,y) = y*BOARD_STRIDE + x
+// (see bitboard.h for the dense and padded layouts).  The high bits of b
+// (b >> 6) select which 64‑bit chunk stores that cell; the low bits
+// (b & 63) select the bit within the chunk.  Tables and the cell mailbox use
+// the layout-independent cell index idx = y*12 + x.  Each bitboard tracks only
 // that player’s stones; a move simply sets or clears the bit for the
 // appropriate player and toggles side_to_move.  The Board also maintains a
 // Zobrist hash key that encodes the entire position (including side to move).
+// Finally it keeps a pattern score for every line, so that evaluation does not
+// need to rescan the board.
+
+static_assert(Board::NUM_LINES == NUM_LINES, "Board and line_geometry.h disagree on the lines");
+
+namespace {
+
+// The (up to eight) adjacent cells of every cell, and each cell's bit in the
+// active bitboard layout.
+struct NeighbourTables {
+    int cells[144][8];
+    int count[144];
+    int bit[144];
+
+    NeighbourTables() {
+        for (int y = 0; y < 12; ++y) {
+            for (int x = 0; x < 12; ++x) {
+                int idx = y * 12 + x;
+                bit[idx] = bitIndex(x, y);
+                count[idx] = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        if (dx == 0 && dy == 0) continue;
+                        int nx = x + dx;
+                        int ny = y + dy;
+                        if (nx >= 0 && nx < 12 && ny >= 0 && ny < 12) {
+                            cells[idx][count[idx]++] = ny * 12 + nx;
+                        }
+                    }
+                }
+            }
+        }
+    }
+};
+
+const NeighbourTables neighbourTables;
+
+} // unnamed namespace
 
 // Static member definitions for Zobrist hashing.  These will be
 // initialized when the first Board is constructed.
 bool Board::zobristInitialized = false;
 uint64_t Board::zobristTable[12][12][2];
 uint64_t Board::zobristSide = 0ULL;
+uint64_t Board::symmetricZobrist[144][2][NUM_SYMMETRIES];
 
-Board::Board() : side_to_move(Player::Black) {
+Board::Board() : side_to_move(Player::Black), network(nullptr) {
     // Ensure Zobrist tables are initialized before using them.
     initZobrist();
-    // Initialize bitboards to zero and hashKey to zero.
+    // Initialize bitboards and the hash keys to zero.
     std::memset(bb, 0, sizeof(bb));
-    hashKey = 0ULL;
+    std::memset(cells, 0, sizeof(cells));
+    std::memset(adjacentStones, 0, sizeof(adjacentStones));
+    candidates = Bitboard::none();
+    std::memset(symmetricKeys, 0, sizeof(symmetricKeys));
+    moveCount = 0;
+    winPly[0] = winPly[1] = -1;
 
     // Starting position: white at (6,6) and (5,5),
     // black at (6,5) and (5,6).
@@ -33,11 +81,14 @@ Board::Board() : side_to_move(Player::Black) {
         int positions[][2] = {{6,6}, {5,5}};
         for (auto &p : positions) {
             int idx = index(p[0], p[1]);
-            int c = chunkOf(idx);
-            int off = offsetOf(idx);
+            int bit = bitIndex(p[0], p[1]);
+            int c = chunkOf(bit);
+            int off = offsetOf(bit);
             bb[static_cast<int>(Player::White)][c] |= (1ULL << off);
+            cells[idx] = 2;
+            threatIndex.place(idx, static_cast<int>(Player::White));
             // Update hash for white stone at (x,y).
-            hashKey ^= zobristTable[p[0]][p[1]][static_cast<int>(Player::White)];
+            toggleStoneKeys(idx, static_cast<int>(Player::White));
         }
     }
     // Place black stones and update hash.
@@ -45,22 +96,92 @@ Board::Board() : side_to_move(Player::Black) {
         int positions[][2] = {{6,5}, {5,6}};
         for (auto &p : positions) {
             int idx = index(p[0], p[1]);
-            int c = chunkOf(idx);
-            int off = offsetOf(idx);
+            int bit = bitIndex(p[0], p[1]);
+            int c = chunkOf(bit);
+            int off = offsetOf(bit);
             bb[static_cast<int>(Player::Black)][c] |= (1ULL << off);
+            cells[idx] = 1;
+            threatIndex.place(idx, static_cast<int>(Player::Black));
             // Update hash for black stone at (x,y).
-            hashKey ^= zobristTable[p[0]][p[1]][static_cast<int>(Player::Black)];
+            toggleStoneKeys(idx, static_cast<int>(Player::Black));
         }
     }
     // It is black's turn to move by convention; no need to toggle side marker.
     side_to_move = Player::Black;
+    // Build the candidate set around the opening stones.
+    for (int idx = 0; idx < 144; ++idx) {
+        if (cells[idx] != 0) addToNeighbourhood(idx);
+    }
+    // Encode and score every line once; from here on only the lines through
+    // a changed cell are updated.
+    lineTotal[0] = lineTotal[1] = 0;
+    for (int line = 0; line < NUM_LINES; ++line) {
+        int code[2] = {0, 0};
+        for (int i = 0; i < LINE_CODE_CELLS; ++i) {
+            int state = i < LINE_GEOMETRY.length[line] ? cells[LINE_GEOMETRY.cells[line][i]] : -1;
+            for (int p = 0; p < 2; ++p) {
+                int digit = state == 0 ? 0 : (state == p + 1 ? 1 : 2);
+                code[p] += digit * lineCodeWeight(i);
+            }
+        }
+        lineCodes[line][0] = code[0];
+        lineCodes[line][1] = code[1];
+        lineScores[line][0] = lineScores[line][1] = 0;
+        rescoreLine(line);
+    }
+}
+
+void Board::addToNeighbourhood(int idx) {
+    // The cell itself is no longer a candidate; every empty neighbour is.
+    candidates.clear(neighbourTables.bit[idx]);
+    for (int i = 0; i < neighbourTables.count[idx]; ++i) {
+        int n = neighbourTables.cells[idx][i];
+        if (adjacentStones[n]++ == 0 && cells[n] == 0) {
+            candidates.set(neighbourTables.bit[n]);
+        }
+    }
+}
+
+void Board::removeFromNeighbourhood(int idx) {
+    // Exact inverse of addToNeighbourhood: neighbours that have lost their
+    // last adjacent stone drop out, and the emptied cell returns if it still
+    // touches a stone.
+    for (int i = 0; i < neighbourTables.count[idx]; ++i) {
+        int n = neighbourTables.cells[idx][i];
+        if (--adjacentStones[n] == 0) {
+            candidates.clear(neighbourTables.bit[n]);
+        }
+    }
+    if (adjacentStones[idx] > 0) {
+        candidates.set(neighbourTables.bit[idx]);
+    }
+}
+
+void Board::rescoreLine(int line) {
+    for (int p = 0; p < 2; ++p) {
+        int score = lineCodeScore(lineCodes[line][p]);
+        lineTotal[p] += score - lineScores[line][p];
+        lineScores[line][p] = score;
+    }
+}
+
+void Board::updateLinesThrough(int idx, int p, int sign) {
+    // The cell's digit goes from 0 (empty) to 1 in the codes of player p
+    // and to 2 in the opponent's codes, or back.
+    for (int dir = 0; dir < 4; ++dir) {
+        int line = LINE_GEOMETRY.lineOf[idx][dir];
+        int weight = lineCodeWeight(LINE_GEOMETRY.posOf[idx][dir]);
+        lineCodes[line][p] += sign * weight;
+        lineCodes[line][1 - p] += sign * 2 * weight;
+        rescoreLine(line);
+    }
 }
 
 bool Board::isOccupied(int x, int y) const {
     if (x < 0 || x >= 12 || y < 0 || y >= 12) return true;
-    int idx = index(x, y);
-    int c = chunkOf(idx);
-    int off = offsetOf(idx);
+    int bit = bitIndex(x, y);
+    int c = chunkOf(bit);
+    int off = offsetOf(bit);
     uint64_t mask = 1ULL << off;
     return ((bb[0][c] | bb[1][c]) & mask) != 0ULL;
 }
@@ -84,9 +205,38 @@ void Board::initZobrist() {
         }
     }
     zobristSide = rng();
+    for (int idx = 0; idx < 144; ++idx) {
+        for (int p = 0; p < 2; ++p) {
+            for (int t = 0; t < NUM_SYMMETRIES; ++t) {
+                int image = SYMMETRY.cellOf[t][idx];
+                symmetricZobrist[idx][p][t] = zobristTable[image % 12][image / 12][p];
+            }
+        }
+    }
     zobristInitialized = true;
 }
 
+void Board::toggleStoneKeys(int idx, int p) {
+    const uint64_t *row = symmetricZobrist[idx][p];
+    for (int t = 0; t < NUM_SYMMETRIES; ++t) symmetricKeys[t] ^= row[t];
+}
+
+void Board::toggleSideKeys() {
+    for (int t = 0; t < NUM_SYMMETRIES; ++t) symmetricKeys[t] ^= zobristSide;
+}
+
+uint64_t Board::canonicalKey(int &transform) const {
+    transform = 0;
+    uint64_t best = symmetricKeys[0];
+    for (int t = 1; t < NUM_SYMMETRIES; ++t) {
+        if (symmetricKeys[t] < best) {
+            best = symmetricKeys[t];
+            transform = t;
+        }
+    }
+    return best;
+}
+
 bool Board::makeMove(int x, int y) {
     // Reject moves off the board.
     if (x < 0 || x >= 12 || y < 0 || y >= 12) return false;
@@ -94,102 +244,126 @@ bool Board::makeMove(int x, int y) {
     if (isOccupied(x, y)) {
         return false;
     }
-    // Compute the linear index and locate the 64‑bit chunk and bit offset.
+    // Compute the cell index and locate the 64‑bit chunk and bit offset.
     int idx = index(x, y);
-    int c   = chunkOf(idx);
-    int off = offsetOf(idx);
+    int bit = bitIndex(x, y);
+    int c   = chunkOf(bit);
+    int off = offsetOf(bit);
     // Convert the enum Player to an integer 0 (Black) or 1 (White).
     int playerIndex = static_cast<int>(side_to_move);
     // Set the bit in the current player's bitboard.
     bb[playerIndex][c] |= (1ULL << off);
+    cells[idx] = static_cast<int8_t>(playerIndex + 1);
+    addToNeighbourhood(idx);
+    updateLinesThrough(idx, playerIndex, 1);
+    // A new five can only pass through the stone just placed.
+    ++moveCount;
+    if (threatIndex.place(idx, playerIndex) && winPly[playerIndex] < 0) {
+        winPly[playerIndex] = moveCount;
+    }
     // Update the Zobrist hash: XOR the random value associated with this
     // cell and player.  Toggling a bit on or off is achieved by XORing
     // the same value in makeMove and unmakeMove.
-    hashKey ^= zobristTable[x][y][playerIndex];
+    toggleStoneKeys(idx, playerIndex);
+    if (network != nullptr) network->addStone(networkAccumulator, idx, playerIndex);
     // Toggle side_to_move and update the side marker in the hash.  The side
     // marker ensures that the same board position with different players to
     // move yields a different hash key.
-    side_to_move = (side_to_move == Player::Black) ? Player::White : Player::Black;
-    hashKey ^= zobristSide;
+    side_to_move = opponentOf(side_to_move);
+    toggleSideKeys();
     return true;
 }
 
 bool Board::unmakeMove(int x, int y) {
     // Restore side_to_move by toggling it back and updating the side
     // marker in the hash.  This is the reverse operation of makeMove().
-    side_to_move = (side_to_move == Player::Black) ? Player::White : Player::Black;
-    hashKey ^= zobristSide;
+    side_to_move = opponentOf(side_to_move);
+    toggleSideKeys();
     // Locate the stone's bit in the bitboard.
     int idx  = index(x, y);
-    int c    = chunkOf(idx);
-    int off  = offsetOf(idx);
+    int bit  = bitIndex(x, y);
+    int c    = chunkOf(bit);
+    int off  = offsetOf(bit);
     uint64_t mask = 1ULL << off;
     int p    = static_cast<int>(side_to_move);
     // Clear the bit from the appropriate player's bitboard.
     bb[p][c] &= ~mask;
+    cells[idx] = 0;
+    removeFromNeighbourhood(idx);
+    threatIndex.remove(idx, p);
+    updateLinesThrough(idx, p, -1);
+    if (winPly[p] == moveCount) {
+        winPly[p] = -1;
+    }
+    --moveCount;
     // XOR the corresponding random number to remove the stone from the hash.
-    hashKey ^= zobristTable[x][y][p];
+    toggleStoneKeys(idx, p);
+    if (network != nullptr) network->removeStone(networkAccumulator, idx, p);
     return true;
 }
 
-bool Board::checkWin(Player player) const {
+void Board::attachNetwork(const Network *net) {
+    network = net;
+    if (network != nullptr) network->refresh(networkAccumulator, cells);
+}
+
+bool Board::isWinningMove(int x, int y, Player player) const {
+    if (isOccupied(x, y)) return false;
+    return threatIndex.completesFive(index(x, y), static_cast<int>(player));
+}
+
+Bitboard Board::windowCells(const ThreatIndex::WindowSet &windows, int p) const {
+    // Union of the empty cells of the given five-cell windows, which hold
+    // no opponent stone, so their empty cells are those without a stone
+    // of player p.
+    Bitboard r = Bitboard::none();
+    const uint64_t *own = bb[p];
+    windows.forEach([&](int w) {
+        const uint64_t *m = ThreatIndex::fiveMask(w);
+        for (int c = 0; c < 3; ++c) r.w[c] |= m[c] & ~own[c];
+    });
+    return r;
+}
+
+Bitboard Board::fivePoints(Player player) const {
     int p = static_cast<int>(player);
-    // Iterate over every occupied cell of player p.  For each stone we
-    // attempt to count contiguous stones in four directions.  As soon as
-    // we find a line of length ≥ 5 we can declare a win.
-    for (int y = 0; y < 12; ++y) {
-        for (int x = 0; x < 12; ++x) {
-            int idx = index(x, y);
-            int c   = chunkOf(idx);
-            int off = offsetOf(idx);
-            // Skip if this cell does not contain a stone of player p.
-            if ((bb[p][c] & (1ULL << off)) == 0ULL) {
-                continue;
-            }
-            // For each stone, check four directions: horizontal (1,0),
-            // vertical (0,1), diagonal down‑right (1,1) and diagonal
-            // up‑right (1,−1).  We count contiguous stones in both
-            // directions and sum the lengths.
-            const int dirs[4][2] = {
-                {1, 0},  // horizontal
-                {0, 1},  // vertical
-                {1, 1},  // diagonal down‑right
-                {1, -1}  // diagonal up‑right
-            };
-            for (int d = 0; d < 4; ++d) {
-                int dx = dirs[d][0];
-                int dy = dirs[d][1];
-                int count = 1;
-                // Extend forward in direction (dx,dy).
-                int nx = x + dx;
-                int ny = y + dy;
-                while (nx >= 0 && nx < 12 && ny >= 0 && ny < 12) {
-                    int nidx = index(nx, ny);
-                    int nc   = chunkOf(nidx);
-                    int no   = offsetOf(nidx);
-                    if ((bb[p][nc] & (1ULL << no)) == 0ULL) break;
-                    ++count;
-                    nx += dx;
-                    ny += dy;
-                }
-                // Extend backward in direction (−dx,−dy).
-                nx = x - dx;
-                ny = y - dy;
-                while (nx >= 0 && nx < 12 && ny >= 0 && ny < 12) {
-                    int nidx = index(nx, ny);
-                    int nc   = chunkOf(nidx);
-                    int no   = offsetOf(nidx);
-                    if ((bb[p][nc] & (1ULL << no)) == 0ULL) break;
-                    ++count;
-                    nx -= dx;
-                    ny -= dy;
-                }
-                // If the total count reaches 5 or more, this player wins.
-                if (count >= 5) return true;
-            }
-        }
-    }
-    return false;
+    return windowCells(threatIndex.fives(p, 4), p);
+}
+
+Bitboard Board::fourPoints(Player player) const {
+    int p = static_cast<int>(player);
+    return windowCells(threatIndex.fives(p, 3), p);
+}
+
+Bitboard Board::threePoints(Player player) const {
+    int p = static_cast<int>(player);
+    const uint64_t *own = bb[p];
+    Bitboard r = Bitboard::none();
+    threatIndex.sixes(p, 2).forEach([&](int w) {
+        const uint64_t *in = ThreatIndex::sixInner(w);
+        for (int c = 0; c < 3; ++c) r.w[c] |= in[c] & ~own[c];
+    });
+    return r;
+}
+
+Bitboard Board::threeDefences(Player player) const {
+    int p = static_cast<int>(player);
+    const uint64_t *own = bb[p];
+    Bitboard r = Bitboard::none();
+    threatIndex.sixes(p, 3).forEach([&](int w) {
+        const uint64_t *in = ThreatIndex::sixInner(w);
+        const uint64_t *end = ThreatIndex::sixEnds(w);
+        for (int c = 0; c < 3; ++c) r.w[c] |= (in[c] & ~own[c]) | end[c];
+    });
+    return r;
+}
+
+void Board::scorePlacements(Player player, const int *cells, int count, int *out,
+                            PlacementKernel kernel) const {
+    int p = static_cast<int>(player);
+    gomoku::scorePlacements(&lineCodes[0][0], p, cells, count, out, kernel);
+    int base = lineTotal[p] - lineTotal[1 - p];
+    for (int i = 0; i < count; ++i) out[i] += base;
 }
 
 std::vector<Move> Board::getLegalMoves() const {
@@ -207,62 +381,25 @@ std::vector<Move> Board::getLegalMoves() const {
 
 std::vector<Move> Board::getCandidateMoves() const {
     std::vector<Move> moves;
-    // Compute a minimal axis‑aligned bounding box around all existing stones.
-    int min_x = 12, max_x = -1, min_y = 12, max_y = -1;
-    bool found = false;
-    for (int y = 0; y < 12; ++y) {
-        for (int x = 0; x < 12; ++x) {
-            if (isOccupied(x, y)) {
-                found = true;
-                if (x < min_x) min_x = x;
-                if (x > max_x) max_x = x;
-                if (y < min_y) min_y = y;
-                if (y > max_y) max_y = y;
-            }
-        }
-    }
-    if (!found) {
+    if (!candidates.any() && !occupied().any()) {
         // No stones on the board: play in the centre.  On a 12×12 board the
         // true centre is (5,5) (zero‑indexed).  We return only this move
         // since all other moves are equivalent by symmetry.
         moves.emplace_back(5, 5);
         return moves;
     }
-    // Expand the bounding box by a margin of two cells in all directions.
-    // This focuses search near the existing stones but allows for tactical
-    // moves slightly away from the cluster.  Clamp the box to the board.
-    min_x = std::max(0, min_x - 2);
-    min_y = std::max(0, min_y - 2);
-    max_x = std::min(11, max_x + 2);
-    max_y = std::min(11, max_y + 2);
-    for (int y = min_y; y <= max_y; ++y) {
-        for (int x = min_x; x <= max_x; ++x) {
-            if (!isOccupied(x, y)) {
-                bool neighbor = false;
-                // Only keep cells that have at least one adjacent stone.
-                // Moves far from existing stones are unlikely to matter in
-                // practice and can be ignored to reduce the branching factor.
-                for (int dy = -1; dy <= 1 && !neighbor; ++dy) {
-                    for (int dx = -1; dx <= 1 && !neighbor; ++dx) {
-                        if (dx == 0 && dy == 0) continue;
-                        int nx = x + dx;
-                        int ny = y + dy;
-                        if (nx >= 0 && nx < 12 && ny >= 0 && ny < 12) {
-                            if (isOccupied(nx, ny)) {
-                                neighbor = true;
-                            }
-                        }
-                    }
-                }
-                if (neighbor) {
-                    moves.emplace_back(x, y);
-                }
-            }
-        }
-    }
-    // Rare case: if the bounding box produced no moves (e.g. stones are
-    // isolated with margin=2), fall back to all legal moves.  This ensures
-    // that the engine always has moves to consider.
+    // Only keep empty cells that have at least one adjacent stone.  Moves
+    // far from existing stones are unlikely to matter in practice and can
+    // be ignored to reduce the branching factor.  The set is maintained by
+    // makeMove/unmakeMove; bits are visited in ascending order, i.e. row by
+    // row.
+    moves.reserve(candidates.count());
+    candidates.forEach([&](int bit) {
+        moves.emplace_back(bit % BOARD_STRIDE, bit / BOARD_STRIDE);
+    });
+    // Rare case: if no cell qualifies (the board is full around the
+    // stones), fall back to all legal moves.  This ensures that the engine
+    // always has moves to consider.
     if (moves.empty()) {
         return getLegalMoves();
     }
@@ -271,38 +408,12 @@ std::vector<Move> Board::getCandidateMoves() const {
 
 int Board::getCellState(int x, int y) const {
     if (x < 0 || x >= 12 || y < 0 || y >= 12) return -1;
-    int idx = index(x, y);
-    int c = chunkOf(idx);
-    int off = offsetOf(idx);
-    uint64_t mask = 1ULL << off;
-    if ((bb[static_cast<int>(Player::Black)][c] & mask) != 0ULL) {
-        return 1;
-    }
-    if ((bb[static_cast<int>(Player::White)][c] & mask) != 0ULL) {
-        return 2;
-    }
-    return 0;
+    return cells[index(x, y)];
 }
 
 int Board::countStones(Player player) const {
     int p = static_cast<int>(player);
-    int total = 0;
-    // Use a portable popcount implementation to avoid relying on compiler
-    // built‑ins that might not be available on all compilers.  Brian
-    // Kernighan’s algorithm counts the number of set bits in a 64‑bit
-    // integer by repeatedly clearing the least significant set bit.
-    auto popcount64 = [](uint64_t x) {
-        int cnt = 0;
-        while (x) {
-            x &= (x - 1);
-            ++cnt;
-        }
-        return cnt;
-    };
-    for (int c = 0; c < 3; ++c) {
-        total += popcount64(bb[p][c]);
-    }
-    return total;
+    return Bitboard::fromWords(bb[p]).count();
 }
 
 } // namespace gomoku
\ No newline at end of file
@@ -14,6 +14,15 @@ void HistoryHeuristic::reset() {
     std::memset(table, 0, sizeof(table));
 }
 
+void HistoryHeuristic::scaleDown(int divisor) {
+    if (divisor <= 1) return;
+    for (int x = 0; x < 12; ++x) {
+        for (int y = 0; y < 12; ++y) {
+            table[x][y] /= divisor;
+        }
+    }
+}
+
 void HistoryHeuristic::increment(const Move &m, int depth) {
     // Only update if the coordinates are on the board.
     if (m.x >= 0 && m.x < 12 && m.y >= 0 && m.y < 12) {
@@ -0,0 +1,283 @@
+// network_eval.cpp
+// Loading, accumulator updates and scalar and AVX2 inference of the
+// quantised evaluation network.
+
+#include "network_eval.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GOMOKU_NETWORK_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GOMOKU_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace gomoku {
+
+namespace {
+
+const char NETWORK_MAGIC[8] = {'G', 'M', 'K', 'N', 'N', 'U', 'E', '\0'};
+const std::size_t HEADER_SIZE = 16;
+
+struct NetworkHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t size;
+};
+static_assert(sizeof(NetworkHeader) == HEADER_SIZE, "unexpected network header size");
+
+// Number of int8 inputs of the hidden layer.
+const int L2_INPUTS = 2 * NETWORK_HIDDEN;
+
+int clampActivation(int v) {
+    return std::min(std::max(v, 0), NETWORK_FT_SCALE);
+}
+
+// Convert the output layer's sum to evaluation units and clamp it.
+int outputScore(int64_t out) {
+    int64_t score = out * NETWORK_EVAL_SCALE / (NETWORK_FT_SCALE * NETWORK_OUT_SCALE);
+    score = std::min<int64_t>(std::max<int64_t>(score, -NETWORK_EVAL_MAX), NETWORK_EVAL_MAX);
+    return static_cast<int>(score);
+}
+
+void updateScalar(int16_t *values, const int16_t *row, int sign) {
+    for (int i = 0; i < NETWORK_HIDDEN; ++i) {
+        values[i] = static_cast<int16_t>(values[i] + sign * row[i]);
+    }
+}
+
+int evaluateScalar(const NetworkWeights &w, const int16_t *us, const int16_t *them) {
+    uint8_t input[L2_INPUTS];
+    for (int i = 0; i < NETWORK_HIDDEN; ++i) {
+        input[i] = static_cast<uint8_t>(clampActivation(us[i]));
+        input[NETWORK_HIDDEN + i] = static_cast<uint8_t>(clampActivation(them[i]));
+    }
+    int64_t out = w.outBias;
+    for (int j = 0; j < NETWORK_L2; ++j) {
+        int32_t sum = w.l2Bias[j];
+        for (int i = 0; i < L2_INPUTS; ++i) sum += input[i] * w.l2Weights[j][i];
+        out += clampActivation(sum >> NETWORK_L2_SHIFT) * w.outWeights[j];
+    }
+    return outputScore(out);
+}
+
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+void updateAvx2(int16_t *values, const int16_t *row, int sign) {
+    for (int i = 0; i < NETWORK_HIDDEN; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+        __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        v = sign > 0 ? _mm256_add_epi16(v, r) : _mm256_sub_epi16(v, r);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i), v);
+    }
+}
+
+// Clip 32 accumulator values to [0, FT_SCALE] as bytes, in order.
+__attribute__((target("avx2")))
+__m256i clipAvx2(const int16_t *values) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top = _mm256_set1_epi16(NETWORK_FT_SCALE);
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + 16));
+    a = _mm256_min_epi16(_mm256_max_epi16(a, zero), top);
+    b = _mm256_min_epi16(_mm256_max_epi16(b, zero), top);
+    // packus interleaves the 128-bit lanes of a and b; restore the order.
+    return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8);
+}
+
+__attribute__((target("avx2")))
+int evaluateAvx2(const NetworkWeights &w, const int16_t *us, const int16_t *them) {
+    __m256i input[L2_INPUTS / 32];
+    input[0] = clipAvx2(us);
+    input[1] = clipAvx2(us + 32);
+    input[2] = clipAvx2(them);
+    input[3] = clipAvx2(them + 32);
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top = _mm256_set1_epi32(NETWORK_FT_SCALE);
+    alignas(32) int32_t hidden[NETWORK_L2];
+    for (int j = 0; j < NETWORK_L2; j += 8) {
+        // Eight dot products of 128 bytes.  maddubs cannot saturate: a
+        // pair of products is at most 2 * 127 * 128 in magnitude.
+        __m256i sums[8];
+        for (int k = 0; k < 8; ++k) {
+            const int8_t *row = w.l2Weights[j + k];
+            __m256i s = zero;
+            for (int c = 0; c < L2_INPUTS / 32; ++c) {
+                __m256i wv = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + 32 * c));
+                s = _mm256_add_epi32(s, _mm256_madd_epi16(_mm256_maddubs_epi16(input[c], wv), ones));
+            }
+            sums[k] = s;
+        }
+        __m256i h01 = _mm256_hadd_epi32(sums[0], sums[1]);
+        __m256i h23 = _mm256_hadd_epi32(sums[2], sums[3]);
+        __m256i h45 = _mm256_hadd_epi32(sums[4], sums[5]);
+        __m256i h67 = _mm256_hadd_epi32(sums[6], sums[7]);
+        __m256i h0123 = _mm256_hadd_epi32(h01, h23);
+        __m256i h4567 = _mm256_hadd_epi32(h45, h67);
+        __m256i total = _mm256_add_epi32(_mm256_permute2x128_si256(h0123, h4567, 0x20),
+                                         _mm256_permute2x128_si256(h0123, h4567, 0x31));
+        total = _mm256_add_epi32(total,
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(w.l2Bias + j)));
+        total = _mm256_srai_epi32(total, NETWORK_L2_SHIFT);
+        total = _mm256_min_epi32(_mm256_max_epi32(total, zero), top);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(hidden + j), total);
+    }
+    int64_t out = w.outBias;
+    for (int j = 0; j < NETWORK_L2; ++j) out += hidden[j] * w.outWeights[j];
+    return outputScore(out);
+}
+#endif
+
+} // unnamed namespace
+
+bool networkAvx2Available() {
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+Network::Network()
+    : weights(nullptr), useAvx2(networkAvx2Available()), mapping(nullptr), mappingSize(0) {}
+
+Network::~Network() {
+    close();
+}
+
+void Network::close() {
+#ifdef GOMOKU_NETWORK_MMAP
+    if (mapping != nullptr) munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    weights = nullptr;
+}
+
+bool Network::open(const std::string &path) {
+    close();
+    const unsigned char *data = nullptr;
+    std::size_t size = 0;
+#ifdef GOMOKU_NETWORK_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(HEADER_SIZE)) {
+        size = static_cast<std::size_t>(st.st_size);
+        void *m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+            mapping = m;
+            mappingSize = size;
+            data = static_cast<const unsigned char *>(m);
+        }
+    }
+    ::close(fd);
+#else
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) return false;
+    unsigned char chunk[4096];
+    std::size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    std::fclose(f);
+    data = buffer.data();
+    size = buffer.size();
+#endif
+    if (data == nullptr || size < HEADER_SIZE) {
+        close();
+        return false;
+    }
+    NetworkHeader header;
+    std::memcpy(&header, data, HEADER_SIZE);
+    if (std::memcmp(header.magic, NETWORK_MAGIC, sizeof(NETWORK_MAGIC)) != 0
+        || header.version != FORMAT_VERSION || header.size != sizeof(NetworkWeights)
+        || size != HEADER_SIZE + sizeof(NetworkWeights)) {
+        close();
+        return false;
+    }
+    // The mapping is page aligned and the header keeps the weights at a
+    // multiple of 16 bytes, more than any member needs.
+    weights = reinterpret_cast<const NetworkWeights *>(data + HEADER_SIZE);
+    return true;
+}
+
+void Network::assign(const NetworkWeights &source) {
+    close();
+    buffer.resize(sizeof(NetworkWeights));
+    std::memcpy(buffer.data(), &source, sizeof(NetworkWeights));
+    weights = reinterpret_cast<const NetworkWeights *>(buffer.data());
+}
+
+void Network::setKernel(NetworkKernel kernel) {
+    useAvx2 = kernel != NetworkKernel::Scalar && networkAvx2Available();
+}
+
+bool Network::write(const std::string &path, const NetworkWeights &source) {
+    std::FILE *f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr) return false;
+    NetworkHeader header;
+    std::memcpy(header.magic, NETWORK_MAGIC, sizeof(NETWORK_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.size = static_cast<uint32_t>(sizeof(NetworkWeights));
+    bool ok = std::fwrite(&header, HEADER_SIZE, 1, f) == 1
+        && std::fwrite(&source, sizeof(NetworkWeights), 1, f) == 1;
+    return std::fclose(f) == 0 && ok;
+}
+
+void Network::refresh(NetworkAccumulator &acc, const int8_t *cells) const {
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        std::memcpy(acc.values[perspective], weights->ftBias, sizeof(weights->ftBias));
+    }
+    for (int cell = 0; cell < 144; ++cell) {
+        if (cells[cell] != 0) addStone(acc, cell, cells[cell] - 1);
+    }
+}
+
+void Network::addStone(NetworkAccumulator &acc, int cell, int owner) const {
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        const int16_t *row = weights->ftWeights[networkFeature(perspective, owner, cell)];
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+        if (useAvx2) {
+            updateAvx2(acc.values[perspective], row, 1);
+            continue;
+        }
+#endif
+        updateScalar(acc.values[perspective], row, 1);
+    }
+}
+
+void Network::removeStone(NetworkAccumulator &acc, int cell, int owner) const {
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        const int16_t *row = weights->ftWeights[networkFeature(perspective, owner, cell)];
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+        if (useAvx2) {
+            updateAvx2(acc.values[perspective], row, -1);
+            continue;
+        }
+#endif
+        updateScalar(acc.values[perspective], row, -1);
+    }
+}
+
+int Network::evaluate(const NetworkAccumulator &acc, int side) const {
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+    if (useAvx2) return evaluateAvx2(*weights, acc.values[side], acc.values[1 - side]);
+#endif
+    return evaluateScalar(*weights, acc.values[side], acc.values[1 - side]);
+}
+
+} // namespace gomoku
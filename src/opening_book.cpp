@@ -0,0 +1,178 @@
+// opening_book.cpp
+// Mapping, lookup and writing of opening book files.
+
+#include "opening_book.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define GOMOKU_BOOK_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gomoku {
+
+namespace {
+
+const char BOOK_MAGIC[8] = {'G', 'M', 'K', 'B', 'O', 'O', 'K', '\0'};
+const std::size_t HEADER_SIZE = 16;
+
+struct BookHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+};
+static_assert(sizeof(BookHeader) == HEADER_SIZE, "unexpected book header size");
+
+// Records sort by key, then by decreasing weight.
+bool recordBefore(const BookRecord &a, const BookRecord &b) {
+    if (a.key != b.key) return a.key < b.key;
+    return a.weight > b.weight;
+}
+
+} // unnamed namespace
+
+OpeningBook::OpeningBook()
+    : records(nullptr), count(0), mapping(nullptr), mappingSize(0) {}
+
+OpeningBook::~OpeningBook() {
+    close();
+}
+
+void OpeningBook::close() {
+#ifdef GOMOKU_BOOK_MMAP
+    if (mapping != nullptr) munmap(mapping, mappingSize);
+#endif
+    mapping = nullptr;
+    mappingSize = 0;
+    buffer.clear();
+    buffer.shrink_to_fit();
+    records = nullptr;
+    count = 0;
+}
+
+bool OpeningBook::open(const std::string &path) {
+    close();
+    const unsigned char *data = nullptr;
+    std::size_t size = 0;
+#ifdef GOMOKU_BOOK_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(HEADER_SIZE)) {
+        size = static_cast<std::size_t>(st.st_size);
+        void *m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+            mapping = m;
+            mappingSize = size;
+            data = static_cast<const unsigned char *>(m);
+        }
+    }
+    ::close(fd);
+#else
+    std::FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) return false;
+    unsigned char chunk[4096];
+    std::size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        buffer.insert(buffer.end(), chunk, chunk + n);
+    }
+    std::fclose(f);
+    data = buffer.data();
+    size = buffer.size();
+#endif
+    if (data == nullptr || size < HEADER_SIZE) {
+        close();
+        return false;
+    }
+    BookHeader header;
+    std::memcpy(&header, data, HEADER_SIZE);
+    if (std::memcmp(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) != 0
+        || header.version != FORMAT_VERSION
+        || size != HEADER_SIZE + static_cast<std::size_t>(header.count) * sizeof(BookRecord)) {
+        close();
+        return false;
+    }
+    records = reinterpret_cast<const BookRecord *>(data + HEADER_SIZE);
+    count = header.count;
+    return true;
+}
+
+std::size_t OpeningBook::find(uint64_t key, const BookRecord *&first) const {
+    first = nullptr;
+    if (records == nullptr) return 0;
+    const BookRecord *end = records + count;
+    const BookRecord *lo = std::lower_bound(records, end, key,
+        [](const BookRecord &r, uint64_t k) { return r.key < k; });
+    const BookRecord *hi = lo;
+    while (hi != end && hi->key == key) ++hi;
+    first = lo;
+    return static_cast<std::size_t>(hi - lo);
+}
+
+BookRecord OpeningBook::makeRecord(const Board &board, const Move &m, int weight, int score) {
+    int t;
+    BookRecord r;
+    r.key = board.canonicalKey(t);
+    r.move = static_cast<uint16_t>(SYMMETRY.cellOf[t][m.y * 12 + m.x]);
+    r.weight = static_cast<uint16_t>(weight);
+    r.score = score;
+    return r;
+}
+
+bool OpeningBook::probe(const Board &board, Move &move) const {
+    const BookRecord *first;
+    int t;
+    std::size_t n = find(board.canonicalKey(t), first);
+    int back = inverseSymmetry(t);
+    // Records come heaviest first.  A 64-bit key collision could name an
+    // occupied cell, so each move is checked against the board.
+    for (std::size_t i = 0; i < n; ++i) {
+        if (first[i].move >= 144) continue;
+        int idx = SYMMETRY.cellOf[back][first[i].move];
+        Move m(idx % 12, idx / 12);
+        if (!board.isOccupied(m.x, m.y)) {
+            move = m;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OpeningBook::write(const std::string &path, std::vector<BookRecord> input) {
+    // Merge duplicates: sort by key and move, then fold runs.
+    std::sort(input.begin(), input.end(), [](const BookRecord &a, const BookRecord &b) {
+        if (a.key != b.key) return a.key < b.key;
+        if (a.move != b.move) return a.move < b.move;
+        return a.weight > b.weight;
+    });
+    std::vector<BookRecord> merged;
+    for (const BookRecord &r : input) {
+        if (!merged.empty() && merged.back().key == r.key && merged.back().move == r.move) {
+            uint32_t w = static_cast<uint32_t>(merged.back().weight) + r.weight;
+            merged.back().weight = static_cast<uint16_t>(std::min<uint32_t>(w, 0xFFFF));
+        } else {
+            merged.push_back(r);
+        }
+    }
+    std::sort(merged.begin(), merged.end(), recordBefore);
+
+    std::FILE *f = std::fopen(path.c_str(), "wb");
+    if (f == nullptr) return false;
+    BookHeader header;
+    std::memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+    header.version = FORMAT_VERSION;
+    header.count = static_cast<uint32_t>(merged.size());
+    bool ok = std::fwrite(&header, HEADER_SIZE, 1, f) == 1;
+    if (ok && !merged.empty()) {
+        ok = std::fwrite(merged.data(), sizeof(BookRecord), merged.size(), f) == merged.size();
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+} // namespace gomoku
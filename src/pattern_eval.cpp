@@ -0,0 +1,109 @@
+// pattern_eval.cpp
+// Implementation of the line pattern scoring.
+
+#include "pattern_eval.h"
+
+namespace gomoku {
+
+int patternScore(int count, bool leftOpen, bool rightOpen) {
+    // Assign scores for different pattern types.  Higher numbers reflect
+    // stronger threats.  These values can be tuned for better play.
+    if (count >= 5) {
+        return SCORE_FIVE;
+    }
+    if (count == 4) {
+        if (leftOpen && rightOpen) return SCORE_OPEN_FOUR;
+        if (leftOpen || rightOpen) return SCORE_SIMPLE_FOUR;
+    }
+    if (count == 3) {
+        if (leftOpen && rightOpen) return SCORE_OPEN_THREE;
+        // A three with only one open end is treated as a broken three.
+        if (leftOpen || rightOpen) return SCORE_BROKEN_THREE;
+    }
+    if (count == 2) {
+        if (leftOpen && rightOpen) return SCORE_OPEN_TWO;
+        if (leftOpen || rightOpen) return SCORE_CLOSED_TWO;
+    }
+    return 0;
+}
+
+int gapScore(int stones, bool leftOpen, bool rightOpen) {
+    // A single gap joining two runs: filling it gives a run of stones + 1.
+    if (stones >= 4) {
+        // X_XXX, XX_XX, XXX_X: one move from five, i.e. a four.
+        return SCORE_SIMPLE_FOUR;
+    }
+    if (stones == 3) {
+        // X_XX, XX_X: makes an open four if both outer ends are open.
+        if (leftOpen && rightOpen) return SCORE_OPEN_THREE;
+        if (leftOpen || rightOpen) return SCORE_BROKEN_THREE;
+    }
+    if (stones == 2) {
+        // X_X.
+        if (leftOpen && rightOpen) return SCORE_CLOSED_TWO;
+    }
+    return 0;
+}
+
+int scoreLine(const int8_t *states, int length, int own) {
+    // When we encounter a run of own stones, we measure its length and
+    // check whether the ends are open (i.e. adjacent cells are empty).
+    // patternScore() converts (count, leftOpen, rightOpen) into a
+    // numerical threat value.  A run followed by a single empty cell and
+    // another run is also credited as a gapped shape by gapScore().
+    int score = 0;
+    int i = 0;
+    int prevStart = -1;   // start of the previous run if it ended one cell before i
+    while (i < length) {
+        if (states[i] == own) {
+            int start = i;
+            while (i < length && states[i] == own) ++i;
+            int count = i - start;
+            bool leftOpen = (start - 1 >= 0 && states[start - 1] == 0);
+            bool rightOpen = (i < length && states[i] == 0);
+            score += patternScore(count, leftOpen, rightOpen);
+            if (prevStart >= 0) {
+                bool outerLeft = (prevStart - 1 >= 0 && states[prevStart - 1] == 0);
+                score += gapScore(i - prevStart - 1, outerLeft, rightOpen);
+            }
+            // The next run joins this one if exactly one empty cell follows.
+            prevStart = (rightOpen && i + 1 < length && states[i + 1] == own) ? start : -1;
+        } else {
+            ++i;
+        }
+    }
+    return score;
+}
+
+namespace {
+
+// Score of every line code, built once from scoreLine().
+struct LineCodeTable {
+    int score[NUM_LINE_CODES];
+
+    LineCodeTable() {
+        int8_t states[LINE_CODE_CELLS];
+        for (int code = 0; code < NUM_LINE_CODES; ++code) {
+            int rest = code;
+            for (int i = 0; i < LINE_CODE_CELLS; ++i) {
+                states[i] = static_cast<int8_t>(rest % 3);
+                rest /= 3;
+            }
+            score[code] = scoreLine(states, LINE_CODE_CELLS, 1);
+        }
+    }
+};
+
+const LineCodeTable lineCodeTable;
+
+} // unnamed namespace
+
+int lineCodeScore(int code) {
+    return lineCodeTable.score[code];
+}
+
+const int *lineCodeScores() {
+    return lineCodeTable.score;
+}
+
+} // namespace gomoku
@@ -0,0 +1,136 @@
+// placement_eval.cpp
+// Scalar and AVX2 kernels for scorePlacements.
+
+#include "placement_eval.h"
+
+#include <chrono>
+
+#include "line_geometry.h"
+#include "pattern_eval.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GOMOKU_HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace gomoku {
+
+namespace {
+
+// For every direction and cell: the line through the cell, doubled to
+// index the [line][player] code array, and the cell's weight in that
+// line's code.  Laid out by direction so that a gather over cell indices
+// reads one row.
+struct PlacementTables {
+    int codeSlot[4][144];
+    int weight[4][144];
+
+    PlacementTables() {
+        for (int dir = 0; dir < 4; ++dir) {
+            for (int idx = 0; idx < 144; ++idx) {
+                codeSlot[dir][idx] = 2 * LINE_GEOMETRY.lineOf[idx][dir];
+                weight[dir][idx] = lineCodeWeight(LINE_GEOMETRY.posOf[idx][dir]);
+            }
+        }
+    }
+};
+
+const PlacementTables placementTables;
+
+void scoreScalar(const int *lineCodes, int p, const int *cells, int count, int *delta) {
+    const int *table = lineCodeScores();
+    for (int i = 0; i < count; ++i) {
+        int idx = cells[i];
+        int sum = 0;
+        for (int dir = 0; dir < 4; ++dir) {
+            const int *codes = lineCodes + placementTables.codeSlot[dir][idx];
+            int w = placementTables.weight[dir][idx];
+            int own = codes[p];
+            int opp = codes[1 - p];
+            sum += (table[own + w] - table[own]) - (table[opp + 2 * w] - table[opp]);
+        }
+        delta[i] = sum;
+    }
+}
+
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+__attribute__((target("avx2")))
+void scoreAvx2(const int *lineCodes, int p, const int *cells, int count, int *delta) {
+    const int *table = lineCodeScores();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cells + i));
+        __m256i sum = _mm256_setzero_si256();
+        for (int dir = 0; dir < 4; ++dir) {
+            __m256i slot = _mm256_i32gather_epi32(placementTables.codeSlot[dir], idx, 4);
+            __m256i w = _mm256_i32gather_epi32(placementTables.weight[dir], idx, 4);
+            __m256i own = _mm256_i32gather_epi32(lineCodes + p, slot, 4);
+            __m256i opp = _mm256_i32gather_epi32(lineCodes + (1 - p), slot, 4);
+            __m256i ownAfter = _mm256_add_epi32(own, w);
+            __m256i oppAfter = _mm256_add_epi32(opp, _mm256_add_epi32(w, w));
+            __m256i gain = _mm256_sub_epi32(_mm256_i32gather_epi32(table, ownAfter, 4),
+                                            _mm256_i32gather_epi32(table, own, 4));
+            __m256i loss = _mm256_sub_epi32(_mm256_i32gather_epi32(table, oppAfter, 4),
+                                            _mm256_i32gather_epi32(table, opp, 4));
+            sum = _mm256_add_epi32(sum, _mm256_sub_epi32(gain, loss));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(delta + i), sum);
+    }
+    scoreScalar(lineCodes, p, cells + i, count - i, delta + i);
+}
+#endif
+
+} // unnamed namespace
+
+bool placementAvx2Available() {
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+    static const bool available = __builtin_cpu_supports("avx2");
+    return available;
+#else
+    return false;
+#endif
+}
+
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+namespace {
+
+// Gathers are fast on some AVX2 processors and slow on others (notably
+// with microcode mitigations against gather data sampling), so the
+// automatic choice times both kernels once on a full candidate list and
+// keeps the faster.  Both kernels produce identical results.
+bool avx2IsFaster() {
+    int codes[2 * NUM_LINES];
+    for (int line = 0; line < NUM_LINES; ++line) codes[2 * line] = codes[2 * line + 1] = 0;
+    int cells[144];
+    int delta[144];
+    for (int i = 0; i < 144; ++i) cells[i] = i;
+    auto time = [&](void (*kernel)(const int *, int, const int *, int, int *)) {
+        auto start = std::chrono::steady_clock::now();
+        for (int rep = 0; rep < 64; ++rep) kernel(codes, rep & 1, cells, 144, delta);
+        return std::chrono::steady_clock::now() - start;
+    };
+    time(scoreScalar);
+    time(scoreAvx2);
+    return time(scoreAvx2) < time(scoreScalar);
+}
+
+} // unnamed namespace
+#endif
+
+void scorePlacements(const int *lineCodes, int p, const int *cells, int count,
+                     int *delta, PlacementKernel kernel) {
+#ifdef GOMOKU_HAVE_AVX2_KERNEL
+    if (kernel != PlacementKernel::Scalar && placementAvx2Available()) {
+        static const bool preferAvx2 = avx2IsFaster();
+        if (kernel == PlacementKernel::Avx2 || preferAvx2) {
+            scoreAvx2(lineCodes, p, cells, count, delta);
+            return;
+        }
+    }
+#else
+    (void)kernel;
+#endif
+    scoreScalar(lineCodes, p, cells, count, delta);
+}
+
+} // namespace gomoku
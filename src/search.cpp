@@ -1,8 +1,11 @@
 #include "search.h"
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <limits>
-#include <unordered_map>
+#include <thread>
 #include <utility>
 
 // Include history heuristic for move ordering.
@@ -10,15 +13,124 @@
 
 namespace gomoku {
 
-SearchEngine::SearchEngine() : maxDepthReached(0) {
+namespace {
+
+// Scores beyond WIN_BOUND are wins or losses, offset by their distance from
+// the root.  The table stores them relative to the node instead, so that an
+// entry stays correct when the position is reached at a different ply.
+const int WIN_BOUND = 90000000;
+
+int scoreToTable(int score, int ply) {
+    if (score > WIN_BOUND) return score + ply;
+    if (score < -WIN_BOUND) return score - ply;
+    return score;
+}
+
+int scoreFromTable(int score, int ply) {
+    if (score > WIN_BOUND) return score - ply;
+    if (score < -WIN_BOUND) return score + ply;
+    return score;
+}
+
+// Late move reductions, in plies, by remaining depth and by the number of
+// moves already searched at the node: ln(depth) * ln(moves) / 2, so
+// reductions grow slowly with both.
+const int LMR_DEPTHS = 64;
+const int LMR_MIN_DEPTH = 3;
+const int LMR_MIN_MOVES = 3;
+
+struct ReductionTable {
+    int r[LMR_DEPTHS][MAX_MOVES];
+    ReductionTable() {
+        for (int d = 0; d < LMR_DEPTHS; ++d) {
+            for (int i = 0; i < MAX_MOVES; ++i) {
+                r[d][i] = d > 0 && i > 0
+                    ? static_cast<int>(std::log(d) * std::log(i) / 2.0) : 0;
+            }
+        }
+    }
+};
+
+const ReductionTable REDUCTIONS;
+
+// Quiet moves searched before move-count pruning applies, by remaining
+// depth.
+const int MOVE_COUNT_LIMIT[] = {0, 8, 14, 22, 32, 44};
+const int MOVE_COUNT_MAX_DEPTH = 5;
+
+// Image of m under symmetry t; (-1,-1) stays as it is.
+Move transformMove(const Move &m, int t) {
+    if (m.x < 0) return m;
+    int idx = SYMMETRY.cellOf[t][m.y * 12 + m.x];
+    return Move(idx % 12, idx / 12);
+}
+
+} // unnamed namespace
+
+SearchEngine::SearchEngine(const SearchConfig &config)
+    : deadlineOverride(std::numeric_limits<int64_t>::max()), deadlineOverrideMs(0),
+      seenOverride(std::numeric_limits<int64_t>::max()), stopRequest(false),
+      helperStop(false), sharedStop(nullptr), stopping(false),
+      lastColor(Player::Black), hasSearched(false), config(config),
+      ownTable(new TranspositionTable(config.ttSizeMb)), transTable(*ownTable),
+      plyStack(MAX_PLY + 1) {
+    clearKillers();
+    if (!config.bookPath.empty()) book.open(config.bookPath);
+    if (this->config.evaluator == Evaluator::Network
+        && (config.networkPath.empty() || !network.open(config.networkPath))) {
+        this->config.evaluator = Evaluator::Pattern;
+    }
+}
+
+SearchEngine::SearchEngine(const SearchConfig &config, TranspositionTable &sharedTable,
+                           const std::atomic<bool> &stop)
+    : deadlineOverride(std::numeric_limits<int64_t>::max()), deadlineOverrideMs(0),
+      seenOverride(std::numeric_limits<int64_t>::max()), stopRequest(false),
+      helperStop(false), sharedStop(&stop), stopping(false),
+      lastColor(Player::Black), hasSearched(false), config(config),
+      transTable(sharedTable), plyStack(MAX_PLY + 1) {
+    clearKillers();
+}
+
+void SearchEngine::clearKillers() {
+    for (int i = 0; i < MAX_PLY; ++i) {
+        killerMoves[i][0] = Move(-1, -1);
+        killerMoves[i][1] = Move(-1, -1);
+    }
+}
+
+uint64_t SearchEngine::nodesSearched() const {
+    return lastStats.nodes;
+}
+
+void SearchEngine::generateCandidates(const Board &board, MoveList &out) const {
+    // Same moves as Board::getCandidateMoves(), read from the board's
+    // incrementally maintained candidate set without allocating.
+    out.clear();
+    const Bitboard &mask = board.candidateMask();
+    if (mask.any()) {
+        mask.forEach([&](int bit) {
+            out.push_back(Move(bit % BOARD_STRIDE, bit / BOARD_STRIDE));
+        });
+    } else if (!board.occupied().any()) {
+        out.push_back(Move(5, 5));
+    } else {
+        board.emptyCells().forEach([&](int bit) {
+            out.push_back(Move(bit % BOARD_STRIDE, bit / BOARD_STRIDE));
+        });
+    }
 }
 
 // Determine whether an opening move should be played for the current position.
-// This simple opening book looks for the very first move (after the
-// predetermined starting stones) and chooses a central point that expands
-// the initial cross.  For Black, it recommends playing on the diagonal at
-// (7,7).  For White or later positions, no opening move is returned.
+// A position found in the opening book is answered with its heaviest book
+// move.  Without a book entry, the very first move (after the
+// predetermined starting stones) is a central point that expands the
+// initial cross: for Black, the diagonal point (7,7).  For White or later
+// positions, no opening move is returned.
 bool SearchEngine::getOpeningMove(const Board &board, Player myColor, Move &outMove) const {
+    if (board.sideToMove() == myColor && book.probe(board, outMove)) {
+        return true;
+    }
     // Count total stones on the board.
     int total = board.countStones(Player::Black) + board.countStones(Player::White);
     // The predetermined position has 4 stones.  We provide a book move only
@@ -42,473 +154,852 @@ bool SearchEngine::getOpeningMove(const Board &board, Player myColor, Move &outM
 }
 
 void SearchEngine::startTimer(int timeLimitMs) {
-    timeEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeLimitMs);
-    maxDepthReached = 0;
+    timeEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(capFor(timeLimitMs));
+    stopping = false;
+    timeManager.start(timeLimitMs, capFor(timeLimitMs));
+    seenOverride = std::numeric_limits<int64_t>::max();
 }
 
-bool SearchEngine::timeUp() const {
-    return std::chrono::steady_clock::now() >= timeEnd;
-}
-
-int SearchEngine::patternScore(int count, bool leftOpen, bool rightOpen) const {
-    // Assign scores for different pattern types.  Higher numbers reflect
-    // stronger threats.  These values can be tuned for better play.
-    // Threat weights.  Larger values correspond to stronger threats.
-    const int SCORE_FIVE           = 100000000;
-    const int SCORE_OPEN_FOUR      = 10000000;
-    const int SCORE_SIMPLE_FOUR    = 1000000;
-    const int SCORE_OPEN_THREE     = 100000;
-    const int SCORE_BROKEN_THREE   = 10000;
-    const int SCORE_OPEN_TWO       = 1000;
-    const int SCORE_CLOSED_TWO     = 100;
-    if (count >= 5) {
-        return SCORE_FIVE;
-    }
-    if (count == 4) {
-        if (leftOpen && rightOpen) return SCORE_OPEN_FOUR;
-        if (leftOpen || rightOpen) return SCORE_SIMPLE_FOUR;
-    }
-    if (count == 3) {
-        if (leftOpen && rightOpen) return SCORE_OPEN_THREE;
-        // A three with only one open end is treated as a broken three.
-        if (leftOpen || rightOpen) return SCORE_BROKEN_THREE;
-    }
-    if (count == 2) {
-        if (leftOpen && rightOpen) return SCORE_OPEN_TWO;
-        if (leftOpen || rightOpen) return SCORE_CLOSED_TWO;
-    }
-    return 0;
-}
-
-// Evaluate the board from a player's perspective by scanning rows,
-// columns and both diagonals for contiguous runs of stones.  Only
-// straight runs are considered; broken patterns (e.g., "xx.x") are
-// not recognized explicitly but may still be partially credited.
-int SearchEngine::evaluatePlayer(const Board &board, Player player) const {
-    // Convert the board bitboards into a 2D integer array for easier
-    // scanning.  We use the values 1 for the target player's stones,
-    // -1 for the opponent's stones and 0 for empty.  This representation
-    // allows us to recognise contiguous runs by simple loops.
-    int grid[12][12];
-    for (int y = 0; y < 12; ++y) {
-        for (int x = 0; x < 12; ++x) {
-            int state = board.getCellState(x, y);
-            if (state == 0) {
-                grid[y][x] = 0;
-            } else if ((state == 1 && player == Player::Black) || (state == 2 && player == Player::White)) {
-                // Current player's stone is represented by +1
-                grid[y][x] = 1;
-            } else {
-                // Opponent's stone is represented by -1
-                grid[y][x] = -1;
-            }
-        }
+void SearchEngine::pollStop() {
+    if (stopping) return;
+    if (sharedStop != nullptr) {
+        stopping = sharedStop->load(std::memory_order_relaxed);
+        return;
     }
-    int score = 0;
-    // --- Rows ---
-    // Scan each row.  When we encounter a run of 1s, we measure its length
-    // and check whether the ends are open (i.e. adjacent cells are empty).
-    // The patternScore() function converts (count, leftOpen, rightOpen)
-    // into a numerical threat value.
-    for (int y = 0; y < 12; ++y) {
-        int x = 0;
-        while (x < 12) {
-            if (grid[y][x] == 1) {
-                int x1 = x;
-                while (x < 12 && grid[y][x] == 1) ++x;
-                int count = x - x1;
-                bool leftOpen = (x1 - 1 >= 0 && grid[y][x1 - 1] == 0);
-                bool rightOpen = (x < 12 && grid[y][x] == 0);
-                score += patternScore(count, leftOpen, rightOpen);
-            } else {
-                ++x;
-            }
-        }
-    }
-    // --- Columns ---
-    for (int x = 0; x < 12; ++x) {
-        int y = 0;
-        while (y < 12) {
-            if (grid[y][x] == 1) {
-                int y1 = y;
-                while (y < 12 && grid[y][x] == 1) ++y;
-                int count = y - y1;
-                bool leftOpen = (y1 - 1 >= 0 && grid[y1 - 1][x] == 0);
-                bool rightOpen = (y < 12 && grid[y][x] == 0);
-                score += patternScore(count, leftOpen, rightOpen);
-            } else {
-                ++y;
-            }
+    auto now = std::chrono::steady_clock::now();
+    int64_t override = deadlineOverride.load(std::memory_order_relaxed);
+    if (override != seenOverride) {
+        // setDeadline() gave the search a new limit from now.
+        seenOverride = override;
+        if (override != std::numeric_limits<int64_t>::max()) {
+            int ms = deadlineOverrideMs.load(std::memory_order_relaxed);
+            timeManager.restart(ms, capFor(ms));
         }
     }
-    // --- Diagonals (top‑left to bottom‑right) ---
-    // For each diagonal index from -(rows-1) to (cols-1)
-    for (int k = -11; k <= 11; ++k) {
-        int xStart = std::max(0, k);
-        int yStart = std::max(0, -k);
-        int len = std::min(12 - xStart, 12 - yStart);
-        int i = 0;
-        while (i < len) {
-            int xcur = xStart + i;
-            int ycur = yStart + i;
-            if (grid[ycur][xcur] == 1) {
-                int j = i;
-                while (j < len) {
-                    int xj = xStart + j;
-                    int yj = yStart + j;
-                    if (grid[yj][xj] != 1) break;
-                    ++j;
-                }
-                int count = j - i;
-                bool leftOpen = false;
-                if (i - 1 >= 0) {
-                    int xl = xStart + (i - 1);
-                    int yl = yStart + (i - 1);
-                    if (grid[yl][xl] == 0) leftOpen = true;
-                }
-                bool rightOpen = false;
-                if (j < len) {
-                    int xr = xStart + j;
-                    int yr = yStart + j;
-                    if (grid[yr][xr] == 0) rightOpen = true;
-                }
-                score += patternScore(count, leftOpen, rightOpen);
-                i = j;
-            } else {
-                ++i;
-            }
-        }
+    if (stopRequest.load(std::memory_order_relaxed) || now >= timeEnd
+        || now.time_since_epoch().count() >= override
+        || (config.maxNodes > 0 && stats.nodes >= config.maxNodes)) {
+        // Tell the helpers as well.
+        helperStop.store(true, std::memory_order_relaxed);
+        stopping = true;
     }
-    // --- Anti‑diagonals (top‑right to bottom‑left) ---
-    // For each anti-diagonal index (x+y) from 0 to 22
-    for (int s = 0; s <= 22; ++s) {
-        int xStart = std::max(0, s - 11);
-        int yStart = std::min(11, s);
-        int len = std::min(yStart + 1, 12 - xStart);
-        int i = 0;
-        while (i < len) {
-            int xcur = xStart + i;
-            int ycur = yStart - i;
-            if (grid[ycur][xcur] == 1) {
-                int j = i;
-                while (j < len) {
-                    int xj = xStart + j;
-                    int yj = yStart - j;
-                    if (grid[yj][xj] != 1) break;
-                    ++j;
-                }
-                int count = j - i;
-                bool leftOpen = false;
-                if (i - 1 >= 0) {
-                    int xl = xStart + (i - 1);
-                    int yl = yStart - (i - 1);
-                    if (grid[yl][xl] == 0) leftOpen = true;
-                }
-                bool rightOpen = false;
-                if (j < len) {
-                    int xr = xStart + j;
-                    int yr = yStart - j;
-                    if (grid[yr][xr] == 0) rightOpen = true;
-                }
-                score += patternScore(count, leftOpen, rightOpen);
-                i = j;
-            } else {
-                ++i;
-            }
-        }
+}
+
+void SearchEngine::setDeadline(int timeLimitMs) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(capFor(timeLimitMs));
+    deadlineOverrideMs.store(timeLimitMs, std::memory_order_relaxed);
+    deadlineOverride.store(end.time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+void SearchEngine::resetStop() {
+    stopRequest.store(false, std::memory_order_relaxed);
+    deadlineOverride.store(std::numeric_limits<int64_t>::max(), std::memory_order_relaxed);
+}
+
+bool SearchEngine::expectedMove(const Board &board, Move &out) const {
+    int symmetry;
+    uint64_t key = tableKey(board, symmetry);
+    TTEntry entry;
+    if (!transTable.probe(key, entry)) return false;
+    Move m = transformMove(entry.bestMove, inverseSymmetry(symmetry));
+    if (m.x < 0 || !isCandidate(board, m)) return false;
+    out = m;
+    return true;
+}
+
+void SearchEngine::principalVariation(const Board &board, MoveList &out) const {
+    out.clear();
+    Board walk = board;
+    Move m;
+    while (out.size() < MAX_PLY && !walk.hasWinner() && expectedMove(walk, m)) {
+        out.push_back(m);
+        walk.makeMove(m.x, m.y);
     }
-    return score;
 }
 
-int SearchEngine::evaluate(const Board &board, Player myColor) const {
+uint64_t SearchEngine::tableKey(const Board &board, int &symmetry) const {
+    if (config.symmetricTT) return board.canonicalKey(symmetry);
+    symmetry = 0;
+    return board.getHashKey();
+}
+
+template <Player Us>
+int SearchEngine::evaluate(const Board &board) const {
     // Evaluate the board as the difference between the current player's
     // pattern score and the opponent's pattern score.  A positive value
-    // indicates that myColor has more or stronger threats on the board.
-    Player opponent = (myColor == Player::Black ? Player::White : Player::Black);
-    int myScore = evaluatePlayer(board, myColor);
-    int oppScore = evaluatePlayer(board, opponent);
-    return myScore - oppScore;
+    // indicates that Us has more or stronger threats on the board.
+    // Both pattern scores are kept up to date by the board itself.  With
+    // the network evaluator, the board likewise keeps the network's first
+    // layer up to date and the score is the network's.
+    if (config.evaluator == Evaluator::Network) return board.networkScore(Us);
+    return board.lineScore(Us) - board.lineScore(opponentOf(Us));
 }
 
-int SearchEngine::alphaBeta(Board &board, int depth, int alpha, int beta,
-                  Player currentPlayer, Player myColor, int ply) {
-    // This function implements a classic alpha–beta search with a
-    // transposition table and various move ordering heuristics.  It
-    // returns a score from the perspective of myColor.  The parameters
-    // alpha and beta store the best scores found so far along the path
-    // and allow pruning: if the current node's score is worse than the
-    // existing alpha/beta window, further exploration can be skipped.
-    // The parameter currentPlayer determines whose turn it is to move,
-    // while ply is the depth from the root and is used for killer moves.
+template <Player Us>
+int SearchEngine::alphaBeta(Board &board, int depth, int alpha, int beta, int ply) {
+    // Negamax alpha–beta search with a transposition table, principal
+    // variation search and staged move ordering.  The score is from the
+    // perspective of Us, the side to move; a child's score is
+    // negated on the way back up.  alpha and beta bound the scores that
+    // still matter along the current path, and ply is the distance from
+    // the root, used for killer moves and the move arena.
 
     // Check for time expiration early.
     if (timeUp()) {
         return 0;
     }
-    // Depth limit or terminal evaluation.
-    if (depth <= 0) {
-        return evaluate(board, myColor);
+    if ((++stats.nodes & (TIME_CHECK_NODES - 1)) == 0) {
+        pollStop();
     }
-    // Check for immediate wins.  If myColor has five in a row, return a large
-    // positive value.  If the opponent has five in a row, return a large
-    // negative value.  We use a depth penalty to prefer shorter wins and
-    // longer losses.
-    if (board.checkWin(myColor)) {
-        return 100000000 - (maxDepthReached - depth);
+    if (ply > stats.seldepth) stats.seldepth = ply;
+    // A five ends the game.  Normally only the player who just moved can
+    // have one; wins are worth less the further they are from the root, so
+    // shorter wins and longer losses are preferred.
+    constexpr Player Them = opponentOf(Us);
+    if (board.checkWin(Them)) {
+        return -WIN_SCORE + ply;
     }
-    Player opponent = (myColor == Player::Black ? Player::White : Player::Black);
-    if (board.checkWin(opponent)) {
-        return -100000000 + (maxDepthReached - depth);
+    if (board.checkWin(Us)) {
+        return WIN_SCORE - ply;
+    }
+    // Depth limit or terminal evaluation.  The per-ply arena bounds the
+    // depth of the tree as well.
+    if (depth <= 0 || ply >= MAX_PLY) {
+        // A short run of fours the side to move can force is a win the
+        // static evaluation cannot see.  It needs a first four, so only
+        // leaves where the side to move can make one are searched.
+        if (config.threatSpace && board.fourPoints(Us).any()) {
+            Move winMove;
+            int plies;
+            bool won;
+            {
+                CycleTimer timer(stats.threatSpaceCycles);
+                won = threatSpace.findVcf(board, LEAF_VCF_MOVES, LEAF_VCF_NODES, winMove, plies);
+            }
+            stats.qnodes += threatSpace.nodesSearched();
+            if (won) {
+                return WIN_SCORE - ply - plies;
+            }
+        }
+        if (config.quiescence && ply < MAX_PLY) {
+            qsBudget = QS_MAX_NODES;
+            return quiescence<Us>(board, alpha, beta, ply, 0);
+        }
+        CycleTimer timer(stats.evalCycles);
+        return evaluate<Us>(board);
     }
 
-    // Look up this position in the transposition table.
-    uint64_t key = board.getHashKey();
-    auto it = transTable.find(key);
-    if (it != transTable.end()) {
-        const TTEntry &entry = it->second;
+    // Look up this position in the transposition table.  Even when the
+    // stored result is too shallow to use, its best move is the most
+    // likely move to refute this position and is tried first.
+    int symmetry;
+    uint64_t key = tableKey(board, symmetry);
+    TTEntry entry;
+    Move ttMove(-1, -1);
+    ++stats.ttProbes;
+    if (transTable.probe(key, entry)) {
+        ++stats.ttHits;
+        ttMove = transformMove(entry.bestMove, inverseSymmetry(symmetry));
         // Only use the entry if it was searched to at least the same depth.
         if (entry.depth >= depth) {
+            int ttScore = scoreFromTable(entry.score, ply);
             if (entry.flag == 0) {
-                return entry.score;
+                ++stats.ttCutoffs;
+                return ttScore;
             } else if (entry.flag == 1) {
-                // Lower bound: value >= entry.score
-                if (entry.score > alpha) alpha = entry.score;
+                // Lower bound: value >= ttScore
+                if (ttScore > alpha) alpha = ttScore;
             } else if (entry.flag == 2) {
-                // Upper bound: value <= entry.score
-                if (entry.score < beta) beta = entry.score;
+                // Upper bound: value <= ttScore
+                if (ttScore < beta) beta = ttScore;
             }
             if (alpha >= beta) {
-                return entry.score;
+                ++stats.ttCutoffs;
+                return ttScore;
             }
         }
     }
-    // Generate candidate moves.  If there are none, evaluate the position.
-    auto candidateMoves = board.getCandidateMoves();
-    if (candidateMoves.empty()) {
-        return evaluate(board, myColor);
+    // If there are no candidate moves (only possible on a full board),
+    // evaluate the position.
+    if (!board.candidateMask().any() && !board.emptyCells().any()) {
+        CycleTimer timer(stats.evalCycles);
+        return evaluate<Us>(board);
     }
-    // Order the moves using heuristics to improve pruning.  Pass the
-    // current ply so killer moves at this depth can be prioritized.
-    auto ordered = orderMoves(board, currentPlayer, myColor, ply);
+    // Moves are produced in stages by nextMove(): the hash move, immediate
+    // wins and forced blocks, killer moves, then the remaining moves by
+    // history.  Quiet moves are only scored once the earlier stages have
+    // failed to produce a cutoff.
+    MovePicker &picker = plyStack[ply].picker;
+    initPicker<Us>(board, picker, ttMove);
+    Move m;
     // Keep track of the best value and best move found at this node.
     Move bestMove(-1, -1);
-    int bestValue;
+    int bestValue = -SCORE_MAX - 1;
     int alphaOrig = alpha;
-    int betaOrig = beta;
-    if (currentPlayer == myColor) {
-        bestValue = std::numeric_limits<int>::min();
-        for (const auto &m : ordered) {
-            if (timeUp()) break;
-            board.makeMove(m.x, m.y);
-            int val = alphaBeta(board, depth - 1, alpha, beta,
-                                (currentPlayer == Player::Black ? Player::White : Player::Black), myColor, ply + 1);
-            board.unmakeMove(m.x, m.y);
-            if (timeUp()) {
-                return 0;
-            }
-            if (val > bestValue) {
-                bestValue = val;
-                bestMove = m;
-            }
-            if (bestValue > alpha) {
-                alpha = bestValue;
-            }
-            if (alpha >= beta) {
-                // Beta cutoff: record killer move and update history heuristic.
-                if (ply < MAX_PLY) {
-                    if (!(killerMoves[ply][0].x == m.x && killerMoves[ply][0].y == m.y)) {
-                        // Shift existing killer move to second slot.
-                        killerMoves[ply][1] = killerMoves[ply][0];
-                        killerMoves[ply][0] = m;
-                    }
-                }
-                // Increase history heuristic for this move.  Deeper cutoffs get
-                // a larger increment (depth squared).
-                history.increment(m, depth);
-                break;
-            }
+    int searched = 0;
+    while (nextMove<Us>(board, picker, ply, m)) {
+        if (timeUp()) break;
+        // A quiet move neither makes nor blocks a threat; the hash move,
+        // tactical moves and killers never count as quiet.
+        bool quiet = picker.stage == STAGE_QUIET && !picker.forcing.test(bitIndex(m.x, m.y));
+        // Close to the horizon, a quiet move this late in the order almost
+        // never matters once a move that does not lose has been found.
+        if (quiet && depth <= config.moveCountPruningDepth && depth <= MOVE_COUNT_MAX_DEPTH
+            && searched >= MOVE_COUNT_LIMIT[depth] && bestValue > -WIN_BOUND) {
+            continue;
         }
-    } else {
-        bestValue = std::numeric_limits<int>::max();
-        for (const auto &m : ordered) {
-            if (timeUp()) break;
-            board.makeMove(m.x, m.y);
-            int val = alphaBeta(board, depth - 1, alpha, beta,
-                                (currentPlayer == Player::Black ? Player::White : Player::Black), myColor, ply + 1);
-            board.unmakeMove(m.x, m.y);
-            if (timeUp()) {
-                return 0;
+        board.makeMove(m.x, m.y);
+        int val;
+        if (searched == 0 || !config.pvs) {
+            val = -alphaBeta<Them>(board, depth - 1, -beta, -alpha, ply + 1);
+        } else {
+            // Late quiet moves are searched less deeply, more so the later
+            // they come and the less often they have cut off elsewhere.
+            int r = 0;
+            if (config.lateMoveReductions && quiet && depth >= LMR_MIN_DEPTH
+                && searched >= LMR_MIN_MOVES) {
+                r = REDUCTIONS.r[std::min(depth, LMR_DEPTHS - 1)][searched];
+                int h = history.get(m);
+                if (h == 0) {
+                    ++r;
+                } else if (h * 2 >= picker.historyMax) {
+                    --r;
+                }
+                // Nodes with an open window are likely on the principal
+                // variation.
+                if (beta - alpha > 1) --r;
+                r = std::max(0, std::min(r, depth - 2));
             }
-            if (val < bestValue) {
-                bestValue = val;
-                bestMove = m;
+            // The first move is expected to be best.  Later moves only
+            // need to be shown worse, which a null window does cheaply; a
+            // move that fails high is searched again, first at full depth
+            // if it was reduced, then with the full window.
+            val = -alphaBeta<Them>(board, depth - 1 - r, -alpha - 1, -alpha, ply + 1);
+            if (r > 0 && val > alpha && !timeUp()) {
+                val = -alphaBeta<Them>(board, depth - 1, -alpha - 1, -alpha, ply + 1);
             }
-            if (bestValue < beta) {
-                beta = bestValue;
+            if (val > alpha && val < beta && !timeUp()) {
+                val = -alphaBeta<Them>(board, depth - 1, -beta, -alpha, ply + 1);
             }
-            if (alpha >= beta) {
-                // Alpha cutoff: record killer move and update history heuristic.
-                if (ply < MAX_PLY) {
-                    if (!(killerMoves[ply][0].x == m.x && killerMoves[ply][0].y == m.y)) {
-                        killerMoves[ply][1] = killerMoves[ply][0];
-                        killerMoves[ply][0] = m;
-                    }
+        }
+        board.unmakeMove(m.x, m.y);
+        ++searched;
+        if (timeUp()) {
+            return 0;
+        }
+        if (val > bestValue) {
+            bestValue = val;
+            bestMove = m;
+        }
+        if (bestValue > alpha) {
+            alpha = bestValue;
+        }
+        if (alpha >= beta) {
+            ++stats.cutoffs;
+            if (searched == 1) ++stats.firstMoveCutoffs;
+            // Beta cutoff: record killer move and update history heuristic.
+            if (ply < MAX_PLY) {
+                if (!(killerMoves[ply][0].x == m.x && killerMoves[ply][0].y == m.y)) {
+                    // Shift existing killer move to second slot.
+                    killerMoves[ply][1] = killerMoves[ply][0];
+                    killerMoves[ply][0] = m;
                 }
-                history.increment(m, depth);
-                break;
             }
+            // Increase history heuristic for this move.  Deeper cutoffs get
+            // a larger increment (depth squared).
+            history.increment(m, depth);
+            break;
         }
     }
+    // A search interrupted by the timer has an incomplete result; do not
+    // let it reach the table, where it would outlive this search.
+    if (timeUp()) {
+        return 0;
+    }
     // Store the result in the transposition table.
     int flag;
     if (bestValue <= alphaOrig) {
-        // Fails high: an upper bound.
+        // Fails low: an upper bound.
         flag = 2;
-    } else if (bestValue >= betaOrig) {
-        // Fails low: a lower bound.
+    } else if (bestValue >= beta) {
+        // Fails high: a lower bound.
         flag = 1;
     } else {
         // Exact value.
         flag = 0;
     }
-    TTEntry newEntry;
-    newEntry.depth = depth;
-    newEntry.score = bestValue;
-    newEntry.flag = flag;
-    newEntry.bestMove = bestMove;
-    transTable[key] = newEntry;
+    transTable.store(key, depth, scoreToTable(bestValue, ply), flag,
+                     transformMove(bestMove, symmetry));
+    return bestValue;
+}
+
+template <Player Us>
+int SearchEngine::quiescence(Board &board, int alpha, int beta, int ply, int qply) {
+    // Only forcing moves are searched, so the threats on the board are
+    // resolved before the static evaluation is trusted.  The leaf itself
+    // was counted by alphaBeta; the nodes below it are qnodes.
+    constexpr Player Them = opponentOf(Us);
+    if (qply > 0) {
+        ++stats.qnodes;
+        if (ply > stats.seldepth) stats.seldepth = ply;
+        if (board.checkWin(Them)) {
+            return -WIN_SCORE + ply;
+        }
+    }
+    --qsBudget;
+    // A four of ours completes five next move.
+    if (board.fivePoints(Us).any()) {
+        return WIN_SCORE - ply - 1;
+    }
+    bool outOfBudget = qsBudget <= 0 || qply >= QS_MAX_PLY || ply >= MAX_PLY;
+    Bitboard theirFives = board.fivePoints(Them);
+    Bitboard fours = Bitboard::none();
+    Bitboard others = Bitboard::none();
+    int bestValue;
+    if (theirFives.any()) {
+        // A four must be blocked, so there is no standing pat.  Two fours
+        // cannot both be blocked.
+        if (theirFives.count() > 1) {
+            return -WIN_SCORE + ply + 2;
+        }
+        if (outOfBudget) {
+            CycleTimer timer(stats.evalCycles);
+            return evaluate<Us>(board);
+        }
+        others = theirFives;
+        bestValue = -SCORE_MAX - 1;
+    } else {
+        {
+            CycleTimer timer(stats.evalCycles);
+            bestValue = evaluate<Us>(board);
+        }
+        if (bestValue >= beta || outOfBudget) {
+            return bestValue;
+        }
+        if (bestValue > alpha) alpha = bestValue;
+        fours = board.fourPoints(Us);
+        if (qply < QS_THREE_PLIES) {
+            // Against a live three, the moves that matter are the blocks;
+            // otherwise making a live three of our own.
+            Bitboard defences = board.threeDefences(Them);
+            others = (defences.any() ? defences : board.threePoints(Us)).andNot(fours);
+        }
+    }
+    // Fours first: they force the reply.
+    MoveList &moves = plyStack[ply].candidates;
+    moves.clear();
+    fours.forEach([&](int bit) { moves.push_back(Move(bit % BOARD_STRIDE, bit / BOARD_STRIDE)); });
+    others.forEach([&](int bit) { moves.push_back(Move(bit % BOARD_STRIDE, bit / BOARD_STRIDE)); });
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move m = moves[i];
+        board.makeMove(m.x, m.y);
+        int val = -quiescence<Them>(board, -beta, -alpha, ply + 1, qply + 1);
+        board.unmakeMove(m.x, m.y);
+        if (timeUp()) {
+            return 0;
+        }
+        if (val > bestValue) {
+            bestValue = val;
+        }
+        if (bestValue > alpha) {
+            alpha = bestValue;
+        }
+        if (alpha >= beta) {
+            break;
+        }
+    }
     return bestValue;
 }
 
 Move SearchEngine::findBestMove(Board &board, Player myColor, int timeLimitMs) {
+    auto start = std::chrono::steady_clock::now();
+    helperStop.store(false, std::memory_order_relaxed);
+    stats = SearchStats();
+    for (auto &h : helpers) h->stats = SearchStats();
+    // The network follows the search's moves on the board; the caller's
+    // own attachment, if any, is restored afterwards.
+    const Network *callerNetwork = board.attachedNetwork();
+    bool useNetwork = config.evaluator == Evaluator::Network;
+    if (useNetwork) board.attachNetwork(&network);
+    Move move = chooseMove(board, myColor, timeLimitMs);
+    if (useNetwork) board.attachNetwork(callerNetwork);
+    // Helper threads have been joined; add up their counters.
+    lastStats = stats;
+    for (const auto &h : helpers) lastStats.accumulate(h->stats);
+    lastStats.elapsedMs = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    return move;
+}
+
+Move SearchEngine::chooseMove(Board &board, Player myColor, int timeLimitMs) {
     // Set up the timer for this move.  The search will stop when
     // timeUp() becomes true.
     startTimer(timeLimitMs);
-    // Clear the transposition table at the start of each search.  Using
-    // a fresh table prevents reuse of stale entries from previous moves
-    // and bounds the memory footprint.
-    transTable.clear();
-    // Reset the history heuristic table for this search.  History values
-    // accumulate within a single search but are cleared between moves.
-    history.reset();
-    // Reset killer moves.  Mark all moves as invalid (-1,-1).
-    for (int i = 0; i < MAX_PLY; ++i) {
-        killerMoves[i][0] = Move(-1, -1);
-        killerMoves[i][1] = Move(-1, -1);
-    }
-    // Opening book: if we are in the predetermined opening and it is
-    // our turn to move as Black, select a hard‑coded central move.
+    // Opening book: a book position, or the first move as Black, needs no
+    // search.  It is answered before any table maintenance, so a book move
+    // takes microseconds.
     Move bookMove;
     if (getOpeningMove(board, myColor, bookMove)) {
         return bookMove;
     }
+    // In persistent mode the transposition table survives between moves:
+    // the next position is usually two plies below the previous root, so
+    // most of its subtree is already in the table.  Starting a new
+    // generation makes the old entries the first candidates for
+    // replacement.  Scores are stored from the side to move's point of
+    // view, so they stay valid whichever colour the engine plays.
+    bool sameSide = hasSearched && lastColor == myColor;
+    if (config.persistentTT && hasSearched) {
+        transTable.newSearch();
+    } else {
+        // Without a persistent table each search starts from nothing, so
+        // the threat-space proofs are forgotten as well.
+        transTable.clear();
+        threatSpace.clear();
+    }
+    // History values accumulate within a single search.  They are either
+    // cleared between moves or, when keepHistory is set, scaled down so
+    // that they only act as a hint for the new search.
+    if (config.keepHistory && sameSide) {
+        history.scaleDown(config.historyDecay);
+    } else {
+        history.reset();
+    }
+    lastColor = myColor;
+    hasSearched = true;
+    // Reset killer moves.  Mark all moves as invalid (-1,-1).
+    clearKillers();
 
+    // A forced win by continuous fours beats any defence, so it is looked
+    // for before the opponent's threats.
+    Move winMove;
+    int winPlies;
+    int threatNodes = std::max(1000, static_cast<int>(std::min<int64_t>(
+        static_cast<int64_t>(timeLimitMs) * ROOT_THREAT_NODES_PER_MS, ROOT_THREAT_MAX_NODES)));
+    if (config.threatSpace) {
+        bool won;
+        {
+            CycleTimer timer(stats.threatSpaceCycles);
+            won = threatSpace.findVcf(board, ROOT_VCF_MOVES, threatNodes, winMove, winPlies);
+        }
+        stats.qnodes += threatSpace.nodesSearched();
+        if (won) {
+            stats.score = WIN_SCORE - winPlies;
+            return winMove;
+        }
+    }
     // Urgent defensive move: if the opponent has an immediate tactical threat
     // (e.g., open four or a highly flexible three), answer it before starting
     // the full search to avoid time-consuming but obvious defenses.
-    auto defensiveMoves = threatSolver.findBlockingMoves(board, myColor);
+    ThreatSolver::ThreatList &defensiveMoves = plyStack[0].threats;
+    {
+        CycleTimer timer(stats.threatCycles);
+        threatSolver.findBlockingMoves(board, myColor, defensiveMoves);
+    }
     if (!defensiveMoves.empty()) {
         const int CRITICAL_SEVERITY = 500000; // open fours and simple fours.
         if (defensiveMoves.front().severity >= CRITICAL_SEVERITY) {
             return defensiveMoves.front().move;
         }
+        // A single cell that stops an open three leaves little to decide;
+        // the search only has to confirm it against counter-attacks.
+        const int URGENT_SEVERITY = 120000;   // open threes and worse.
+        if (defensiveMoves.front().severity >= URGENT_SEVERITY
+            && (defensiveMoves.size() == 1 || defensiveMoves[1].severity < URGENT_SEVERITY)) {
+            timeManager.setForced();
+        }
+    }
+    // Without an urgent threat to answer, a win by threes and fours is
+    // still forced if it exists.
+    if (config.threatSpace) {
+        bool won;
+        {
+            CycleTimer timer(stats.threatSpaceCycles);
+            won = threatSpace.findVct(board, ROOT_VCT_MOVES, threatNodes, winMove, winPlies);
+        }
+        stats.qnodes += threatSpace.nodesSearched();
+        if (won) {
+            stats.score = WIN_SCORE - winPlies;
+            return winMove;
+        }
+    }
+    // Lazy SMP: start the helper threads on copies of the root position.
+    // They run until the main thread has finished its own search.
+    while (static_cast<int>(helpers.size()) < config.threads - 1) {
+        helpers.emplace_back(new SearchEngine(config, transTable, helperStop));
+    }
+    std::vector<std::thread> workers;
+    for (int i = 0; i < config.threads - 1; ++i) {
+        workers.emplace_back(&SearchEngine::runHelper, helpers[i].get(), board, myColor, i);
     }
+    Move bestMove = iterativeDeepening(board, myColor, 1);
+    helperStop.store(true, std::memory_order_relaxed);
+    for (auto &w : workers) w.join();
+    return bestMove;
+}
+
+void SearchEngine::runHelper(Board board, Player myColor, int helperIndex) {
+    history.reset();
+    clearKillers();
+    stopping = false;
+    // Half of the helpers start one ply deeper than the main thread, so
+    // that the threads spread over neighbouring depths instead of all
+    // searching the same tree in lockstep.
+    iterativeDeepening(board, myColor, 1 + (helperIndex + 1) % 2);
+}
+
+Move SearchEngine::iterativeDeepening(Board &board, Player myColor, int firstDepth) {
     Move bestMove(-1, -1);
     // Generate and order root moves.  These moves will be re‑ordered
     // between iterations based on the values returned by the search.
-    auto rootMoves = orderMoves(board, myColor, myColor, 0);
+    orderMoves(board, myColor, myColor, 0, rootMoves);
     if (rootMoves.empty()) {
         return bestMove;
     }
-    int bestVal = std::numeric_limits<int>::min();
+    // A single candidate needs no search.
+    if (rootMoves.size() == 1 && sharedStop == nullptr) {
+        return rootMoves.front();
+    }
+    // The previous search usually visited this position two plies below its
+    // root, and a persistent table still holds its best move.  Search that
+    // move first.
+    int rootSymmetry;
+    uint64_t rootKey = tableKey(board, rootSymmetry);
+    TTEntry rootEntry;
+    if (transTable.probe(rootKey, rootEntry) && rootEntry.bestMove.x >= 0) {
+        Move hashMove = transformMove(rootEntry.bestMove, inverseSymmetry(rootSymmetry));
+        for (int i = 0; i < rootMoves.size(); ++i) {
+            if (rootMoves[i].x == hashMove.x && rootMoves[i].y == hashMove.y) {
+                std::rotate(rootMoves.begin(), rootMoves.begin() + i, rootMoves.begin() + i + 1);
+                break;
+            }
+        }
+    }
+    int bestVal = 0;
     // Begin iterative deepening: increase the search depth one ply at a time.
-    for (int depth = 1; ; ++depth) {
+    for (int depth = firstDepth; depth <= MAX_PLY; ++depth) {
+        pollStop();
         if (timeUp()) break;
-        maxDepthReached = depth;
-        Move currentBestMove = rootMoves.front();
-        int currentBestVal = std::numeric_limits<int>::min();
-        for (const auto &m : rootMoves) {
-            if (timeUp()) break;
-            board.makeMove(m.x, m.y);
-            int val = alphaBeta(board, depth - 1,
-                                std::numeric_limits<int>::min() + 1,
-                                std::numeric_limits<int>::max() - 1,
-                                (myColor == Player::Black ? Player::White : Player::Black),
-                                myColor,
-                                1);
-            board.unmakeMove(m.x, m.y);
+        if (config.maxDepth > 0 && depth > config.maxDepth) break;
+        // Aspiration window: from the third iteration on, search a narrow
+        // window around the previous score and widen it on failure.  Won or
+        // lost positions use the full window, since their scores move by
+        // large steps.
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -SCORE_MAX;
+        int beta = SCORE_MAX;
+        if (config.pvs && depth >= firstDepth + 2 && std::abs(bestVal) < 50000000) {
+            alpha = std::max(-SCORE_MAX, bestVal - delta);
+            beta = std::min(SCORE_MAX, bestVal + delta);
+        }
+        Move iterationBest = rootMoves.front();
+        bool bestExact = false;
+        int val;
+        while (true) {
+            val = myColor == Player::Black
+                    ? searchRoot<Player::Black>(board, depth, alpha, beta, iterationBest, bestExact)
+                    : searchRoot<Player::White>(board, depth, alpha, beta, iterationBest, bestExact);
             if (timeUp()) break;
-            // If the returned value indicates a certain win (large positive),
-            // we can return this move immediately.
-            if (val > 90000000) {
-                return m;
-            }
-            if (val > currentBestVal) {
-                currentBestVal = val;
-                currentBestMove = m;
+            if (val <= alpha && alpha > -SCORE_MAX) {
+                alpha = std::max(-SCORE_MAX, val - delta);
+            } else if (val >= beta && beta < SCORE_MAX) {
+                beta = std::min(SCORE_MAX, val + delta);
+            } else {
+                break;
             }
+            delta *= 4;
         }
-        if (!timeUp()) {
-            bestVal = currentBestVal;
-            bestMove = currentBestMove;
-        // Reorder root moves based on their values for the next iteration.
-        // Moves that scored better are tried first in deeper searches.
-            std::vector<std::pair<int, Move>> scored;
-            scored.reserve(rootMoves.size());
-            for (const auto &m : rootMoves) {
-                int val;
-                board.makeMove(m.x, m.y);
-                val = alphaBeta(board, depth - 1,
-                                std::numeric_limits<int>::min() + 1,
-                                std::numeric_limits<int>::max() - 1,
-                                (myColor == Player::Black ? Player::White : Player::Black),
-                                myColor,
-                                1);
-                board.unmakeMove(m.x, m.y);
-                scored.push_back({val, m});
-            }
-            std::sort(scored.begin(), scored.end(), [](const std::pair<int, Move> &a, const std::pair<int, Move> &b) {
-                return a.first > b.first;
-            });
-            rootMoves.clear();
-            for (auto &p : scored) rootMoves.push_back(p.second);
-        } else {
+        if (timeUp()) {
+            // An interrupted iteration still improves on the previous one
+            // if its best move so far has an exact score: the first move
+            // was searched completely, and any move that beat it did so
+            // with a full-window search.
+            if (bestExact) bestMove = iterationBest;
+            break;
+        }
+        bestVal = val;
+        bestMove = iterationBest;
+        stats.depth = depth;
+        stats.score = bestVal;
+        // Record the root result like any other node, so later searches
+        // and PV walks find the root's best move in the table.
+        transTable.store(rootKey, depth, bestVal, 0, transformMove(bestMove, rootSymmetry));
+        // If the score indicates a certain win (large positive), there is
+        // nothing left to search for.
+        if (bestVal > WIN_BOUND) {
             break;
         }
+        // Only the main engine manages time; helpers run until stopped.
+        if (config.adaptiveTime && sharedStop == nullptr) {
+            timeManager.iterationDone(bestMove, bestVal);
+            if (!timeManager.startNextIteration()) break;
+        }
+        // Reorder root moves for the next iteration by the scores recorded
+        // during this one, best move first.  Scores of moves that failed
+        // low are upper bounds, which is enough to order them.
+        std::sort(rootScores.begin(), rootScores.end(), [](const ScoredMove &a, const ScoredMove &b) {
+            return a.score > b.score;
+        });
+        rootMoves.clear();
+        rootMoves.push_back(bestMove);
+        for (const auto &p : rootScores) {
+            if (p.move.x != bestMove.x || p.move.y != bestMove.y) rootMoves.push_back(p.move);
+        }
     }
     return bestMove;
 }
 
-std::vector<Move> SearchEngine::orderMoves(Board &board, Player currentPlayer, Player myColor, int ply) {
-    // Generate candidate moves within the board's bounding box and near
-    // existing stones.  These moves form the basis for move ordering.
-    auto moves = board.getCandidateMoves();
-    std::vector<std::pair<int, Move>> scored;
-    scored.reserve(moves.size());
-    Player opponent = (currentPlayer == Player::Black ? Player::White : Player::Black);
+template <Player Us>
+int SearchEngine::searchRoot(Board &board, int depth, int alpha, int beta, Move &bestOut,
+                             bool &bestExact) {
+    // Principal variation search over the root moves.  The first move gets
+    // the full window; every later move is first searched with a null
+    // window just above alpha, which is cheap to refute, and only searched
+    // again with the full window if it turns out to be better.  The score
+    // of each move is recorded in rootScores for the next iteration's
+    // ordering, so a completed iteration costs a single pass.
+    constexpr Player Them = opponentOf(Us);
+    int bestValue = -SCORE_MAX - 1;
+    int alphaOrig = alpha;
+    bestExact = false;
+    rootScores.clear();
+    for (int i = 0; i < rootMoves.size(); ++i) {
+        pollStop();
+        if (timeUp()) break;
+        const Move &m = rootMoves[i];
+        board.makeMove(m.x, m.y);
+        int val;
+        if (i == 0 || !config.pvs) {
+            val = -alphaBeta<Them>(board, depth - 1, -beta, -alpha, 1);
+        } else {
+            val = -alphaBeta<Them>(board, depth - 1, -alpha - 1, -alpha, 1);
+            if (val > alpha && val < beta && !timeUp()) {
+                val = -alphaBeta<Them>(board, depth - 1, -beta, -alpha, 1);
+            }
+        }
+        board.unmakeMove(m.x, m.y);
+        if (timeUp()) break;
+        rootScores.push_back({val, m});
+        if (val > bestValue) {
+            bestValue = val;
+            bestOut = m;
+            bestExact = val > alphaOrig && val < beta;
+        }
+        if (val > alpha) {
+            alpha = val;
+        }
+        if (alpha >= beta) {
+            // Fail high against the aspiration window; the caller widens it.
+            break;
+        }
+    }
+    return bestValue;
+}
+
+template <Player Us>
+void SearchEngine::initPicker(const Board &board, MovePicker &picker, const Move &ttMove) {
+    picker.stage = STAGE_HASH;
+    picker.index = 0;
+    picker.yielded = Bitboard::none();
+    // No moves are generated yet: if the hash move cuts off, the node
+    // returns without generating or scoring anything else.  The hash move
+    // is only kept if it is one of this node's candidates; with a 32-bit
+    // key check it may come from a different position.
+    picker.ttMove = Move(-1, -1);
+    if (ttMove.x >= 0 && isCandidate(board, ttMove)) {
+        picker.ttMove = ttMove;
+    }
+}
+
+bool SearchEngine::isCandidate(const Board &board, const Move &m) const {
+    if (board.isOccupied(m.x, m.y)) return false;
+    const Bitboard &mask = board.candidateMask();
+    // Without candidates next to stones every empty cell is a candidate
+    // (see generateCandidates).
+    return !mask.any() || mask.test(bitIndex(m.x, m.y));
+}
+
+template <Player Us>
+bool SearchEngine::nextMove(Board &board, MovePicker &picker, int ply, Move &out) {
+    PlyBuffers &buffers = plyStack[ply];
+    constexpr Player Them = opponentOf(Us);
+    // Each stage falls through to the next once it is exhausted.  Moves
+    // returned by an earlier stage are recorded in picker.yielded (indexed
+    // by y*12+x) and skipped later.
+    switch (picker.stage) {
+    case STAGE_HASH:
+        picker.stage = STAGE_TACTICAL_INIT;
+        if (picker.ttMove.x >= 0) {
+            picker.yielded.set(picker.ttMove.y * 12 + picker.ttMove.x);
+            out = picker.ttMove;
+            return true;
+        }
+        // fall through
+    case STAGE_TACTICAL_INIT: {
+        // The hash move did not cut off; generate the candidates now.
+        // Immediate wins come first, then cells where the opponent would
+        // complete five.  Both tests are window lookups on the bitboards.
+        CycleTimer timer(stats.orderCycles);
+        generateCandidates(board, buffers.candidates);
+        auto &tactical = buffers.tactical;
+        tactical.clear();
+        for (const auto &c : buffers.candidates) {
+            if (board.isWinningMove(c.x, c.y, Us)) {
+                tactical.push_back({2, c});
+            } else if (board.isWinningMove(c.x, c.y, Them)) {
+                tactical.push_back({1, c});
+            }
+        }
+        std::sort(tactical.begin(), tactical.end(), [](const ScoredMove &a, const ScoredMove &b) {
+            return a.score > b.score;
+        });
+        picker.index = 0;
+        picker.stage = STAGE_TACTICAL;
+    }
+        // fall through
+    case STAGE_TACTICAL:
+        while (picker.index < buffers.tactical.size()) {
+            const Move &c = buffers.tactical[picker.index++].move;
+            int key = c.y * 12 + c.x;
+            if (picker.yielded.test(key)) continue;
+            picker.yielded.set(key);
+            out = c;
+            return true;
+        }
+        picker.index = 0;
+        picker.stage = STAGE_KILLERS;
+        // fall through
+    case STAGE_KILLERS:
+        // Killer moves come from sibling nodes, so they are only played if
+        // they are candidates here as well.
+        while (picker.index < 2) {
+            const Move &k = killerMoves[ply][picker.index++];
+            if (k.x < 0) continue;
+            int key = k.y * 12 + k.x;
+            if (picker.yielded.test(key)) continue;
+            if (!isCandidate(board, k)) continue;
+            picker.yielded.set(key);
+            out = k;
+            return true;
+        }
+        picker.stage = STAGE_QUIET_INIT;
+        // fall through
+    case STAGE_QUIET_INIT: {
+        // Score the remaining moves: the evaluation after each placement,
+        // computed for all of them in one batch from the line codes,
+        // history, the severity of the opponent threats they block, and
+        // closeness to the centre.
+        CycleTimer timer(stats.orderCycles);
+        ThreatSolver::ThreatList &defensiveMoves = buffers.threats;
+        {
+            CycleTimer threatTimer(stats.threatCycles);
+            threatSolver.findBlockingMoves(board, Us, defensiveMoves);
+        }
+        int *defensiveLookup = buffers.defensive;
+        std::memset(defensiveLookup, 0, sizeof(buffers.defensive));
+        for (const auto &t : defensiveMoves) {
+            int key = t.move.y * 12 + t.move.x;
+            if (defensiveLookup[key] < t.severity) {
+                defensiveLookup[key] = t.severity;
+            }
+        }
+        picker.forcing = board.fourPoints(Us) | board.threePoints(Us)
+                       | board.threeDefences(Them) | board.fivePoints(Them);
+        picker.historyMax = 0;
+        int *cells = buffers.cells;
+        int *placed = buffers.placement;
+        int count = 0;
+        for (const auto &c : buffers.candidates) {
+            int key = c.y * 12 + c.x;
+            if (!picker.yielded.test(key)) cells[count++] = key;
+        }
+        board.scorePlacements(Us, cells, count, placed);
+        auto &scored = buffers.scored;
+        scored.clear();
+        for (int i = 0; i < count; ++i) {
+            int key = cells[i];
+            Move c(key % 12, key / 12);
+            if (defensiveLookup[key] > 0) picker.forcing.set(bitIndex(c.x, c.y));
+            int dx = c.x - 5;
+            int dy = c.y - 5;
+            int h = history.get(c);
+            picker.historyMax = std::max(picker.historyMax, h);
+            int score = placed[i] + h + defensiveLookup[key] - (dx * dx + dy * dy);
+            scored.push_back({score, c});
+        }
+        picker.index = 0;
+        picker.stage = STAGE_QUIET;
+    }
+        // fall through
+    case STAGE_QUIET: {
+        // Selection sort: move the best remaining entry into place only
+        // when it is requested, so a cutoff skips sorting the rest.
+        auto &scored = buffers.scored;
+        if (picker.index < scored.size()) {
+            int best = picker.index;
+            for (int i = picker.index + 1; i < scored.size(); ++i) {
+                if (scored[i].score > scored[best].score) best = i;
+            }
+            std::swap(scored[picker.index], scored[best]);
+            out = scored[picker.index++].move;
+            return true;
+        }
+        picker.stage = STAGE_DONE;
+    }
+        // fall through
+    case STAGE_DONE:
+    default:
+        return false;
+    }
+}
+
+void SearchEngine::orderMoves(Board &board, Player currentPlayer, Player myColor, int ply,
+                              MoveList &ordered) {
+    // Generate candidate moves near existing stones.  These moves form the
+    // basis for move ordering.  All scratch lists come from the arena
+    // entry of this ply, so no memory is allocated.
+    CycleTimer timer(stats.orderCycles);
+    PlyBuffers &buffers = plyStack[ply];
+    MoveList &moves = buffers.candidates;
+    generateCandidates(board, moves);
+    auto &scored = buffers.scored;
+    scored.clear();
+    Player opponent = opponentOf(currentPlayer);
 
     // Surface urgent defensive moves against the opponent's most dangerous
     // threats (e.g., open fours or open/broken threes) so they are explored
-    // early.
-    auto defensiveMoves = threatSolver.findBlockingMoves(board, currentPlayer);
-    std::unordered_map<int, int> defensiveLookup;
+    // early.  defensiveLookup holds the best severity per cell (0 = none).
+    ThreatSolver::ThreatList &defensiveMoves = buffers.threats;
+    {
+        CycleTimer threatTimer(stats.threatCycles);
+        threatSolver.findBlockingMoves(board, currentPlayer, defensiveMoves);
+    }
+    int *defensiveLookup = buffers.defensive;
+    std::memset(defensiveLookup, 0, sizeof(buffers.defensive));
     for (const auto &t : defensiveMoves) {
         int key = t.move.y * 12 + t.move.x;
-        if (defensiveLookup.find(key) == defensiveLookup.end() || defensiveLookup[key] < t.severity) {
+        if (defensiveLookup[key] < t.severity) {
             defensiveLookup[key] = t.severity;
         }
     }
-    for (const auto &m : moves) {
+    // Evaluate every candidate in one batch: the board computes the
+    // evaluation after each placement from its line codes without making
+    // the moves.
+    int *cells = buffers.cells;
+    int *placed = buffers.placement;
+    for (int i = 0; i < moves.size(); ++i) {
+        cells[i] = moves[i].y * 12 + moves[i].x;
+    }
+    board.scorePlacements(currentPlayer, cells, moves.size(), placed);
+    // A five already on the board for the opponent outlives any move.
+    bool winForOpp = board.checkWin(opponent);
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move &m = moves[i];
         int score = 0;
-        // Make the move and evaluate consequences.
-        board.makeMove(m.x, m.y);
         // Check for immediate win for the player who plays this move.
-        bool winForCurrent = board.checkWin(currentPlayer);
-        // Check if this move would allow the opponent to win on their next turn.
-        bool winForOpp = board.checkWin(opponent);
+        bool winForCurrent = board.isWinningMove(m.x, m.y, currentPlayer);
         // Evaluate board from myColor perspective; larger is better for myColor.
-        int evalScore = evaluate(board, myColor);
-        board.unmakeMove(m.x, m.y);
+        int evalScore = currentPlayer == myColor ? placed[i] : -placed[i];
         // Scoring heuristic:
         //  * If the move wins immediately for the current player, assign a
         //    very large score to ensure it is tried first.
@@ -526,11 +1017,7 @@ std::vector<Move> SearchEngine::orderMoves(Board &board, Player currentPlayer, P
         int dy = m.y - 5;
         score -= (dx * dx + dy * dy);
         // Prioritize blocking high-severity opponent threats.
-        int key = m.y * 12 + m.x;
-        auto defIt = defensiveLookup.find(key);
-        if (defIt != defensiveLookup.end()) {
-            score += defIt->second;
-        }
+        score += defensiveLookup[m.y * 12 + m.x];
         // Killer move heuristic: if this move is one of the recorded killer moves
         // at the current search ply, add a large bonus.  The first killer move
         // receives a larger bonus than the second.  Killer moves are ones that
@@ -552,16 +1039,15 @@ std::vector<Move> SearchEngine::orderMoves(Board &board, Player currentPlayer, P
         score += history.get(m);
         scored.push_back({score, m});
     }
-    // Sort descending by heuristic score so the best candidates appear first.
-    std::sort(scored.begin(), scored.end(), [](const std::pair<int, Move> &a, const std::pair<int, Move> &b) {
-        return a.first > b.first;
+    // Sort descending by heuristic score so the best candidates appear
+    // first.  std::sort works in place; ties keep no particular order.
+    std::sort(scored.begin(), scored.end(), [](const ScoredMove &a, const ScoredMove &b) {
+        return a.score > b.score;
     });
-    std::vector<Move> ordered;
-    ordered.reserve(scored.size());
+    ordered.clear();
     for (auto &p : scored) {
-        ordered.push_back(p.second);
+        ordered.push_back(p.move);
     }
-    return ordered;
 }
 
-} // namespace gomoku
\ No newline at end of file
+} // namespace gomoku
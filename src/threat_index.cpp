@@ -0,0 +1,163 @@
+// threat_index.cpp
+// Window geometry and incremental updates for ThreatIndex.
+
+#include "threat_index.h"
+
+#include <cstring>
+
+#include "line_geometry.h"
+
+namespace gomoku {
+
+namespace {
+
+// Every window of five and six consecutive cells along the lines of
+// line_geometry.h, and the windows through each cell.  A cell lies in at
+// most five five-cell and six six-cell windows per direction.
+struct WindowTables {
+    uint64_t fiveMask[ThreatIndex::NUM_FIVES][3];
+    int fiveCells[ThreatIndex::NUM_FIVES][7];   // before, five cells, after
+    int fivesOf[144][20];
+    int fivesOfCount[144];
+
+    uint64_t sixInner[ThreatIndex::NUM_SIXES][3];
+    uint64_t sixEnds[ThreatIndex::NUM_SIXES][3];
+    // Windows through each cell, with the low bit set for an end cell.
+    int sixesOf[144][24];
+    int sixesOfCount[144];
+
+    static void setBit(uint64_t mask[3], int idx) {
+        int bit = bitIndex(idx % 12, idx / 12);
+        mask[bit >> 6] |= 1ULL << (bit & 63);
+    }
+
+    WindowTables() {
+        std::memset(this, 0, sizeof(*this));
+        int fives = 0;
+        int sixes = 0;
+        for (int line = 0; line < NUM_LINES; ++line) {
+            const int *cells = LINE_GEOMETRY.cells[line];
+            int len = LINE_GEOMETRY.length[line];
+            for (int start = 0; start + 5 <= len; ++start) {
+                fiveCells[fives][0] = start > 0 ? cells[start - 1] : -1;
+                fiveCells[fives][6] = start + 5 < len ? cells[start + 5] : -1;
+                for (int i = 0; i < 5; ++i) {
+                    int idx = cells[start + i];
+                    fiveCells[fives][i + 1] = idx;
+                    setBit(fiveMask[fives], idx);
+                    fivesOf[idx][fivesOfCount[idx]++] = fives;
+                }
+                ++fives;
+            }
+            for (int start = 0; start + 6 <= len; ++start) {
+                for (int i = 0; i < 6; ++i) {
+                    int idx = cells[start + i];
+                    bool end = (i == 0 || i == 5);
+                    setBit(end ? sixEnds[sixes] : sixInner[sixes], idx);
+                    sixesOf[idx][sixesOfCount[idx]++] = sixes * 2 + (end ? 1 : 0);
+                }
+                ++sixes;
+            }
+        }
+    }
+};
+
+const WindowTables windowTables;
+
+} // unnamed namespace
+
+ThreatIndex::ThreatIndex() {
+    std::memset(fiveCount, 0, sizeof(fiveCount));
+    std::memset(sixInnerCount, 0, sizeof(sixInnerCount));
+    std::memset(sixEndCount, 0, sizeof(sixEndCount));
+    std::memset(fiveSets, 0, sizeof(fiveSets));
+    std::memset(sixSets, 0, sizeof(sixSets));
+}
+
+const uint64_t *ThreatIndex::fiveMask(int w) {
+    return windowTables.fiveMask[w];
+}
+
+int ThreatIndex::fiveCell(int w, int i) {
+    return windowTables.fiveCells[w][i + 1];
+}
+
+const uint64_t *ThreatIndex::sixInner(int w) {
+    return windowTables.sixInner[w];
+}
+
+const uint64_t *ThreatIndex::sixEnds(int w) {
+    return windowTables.sixEnds[w];
+}
+
+void ThreatIndex::updateFive(int w) {
+    for (int p = 0; p < 2; ++p) {
+        fiveSets[p][0].clear(w);
+        fiveSets[p][1].clear(w);
+        int own = fiveCount[w][p];
+        if (fiveCount[w][1 - p] == 0 && own >= 3 && own <= 4) {
+            fiveSets[p][own - 3].set(w);
+        }
+    }
+}
+
+void ThreatIndex::updateSix(int w) {
+    for (int p = 0; p < 2; ++p) {
+        sixSets[p][0].clear(w);
+        sixSets[p][1].clear(w);
+        int own = sixInnerCount[w][p];
+        bool clean = sixEndCount[w][0] == 0 && sixEndCount[w][1] == 0
+                  && sixInnerCount[w][1 - p] == 0;
+        if (clean && own >= 2 && own <= 3) {
+            sixSets[p][own - 2].set(w);
+        }
+    }
+}
+
+bool ThreatIndex::place(int idx, int p) {
+    bool five = false;
+    for (int i = 0; i < windowTables.fivesOfCount[idx]; ++i) {
+        int w = windowTables.fivesOf[idx][i];
+        if (++fiveCount[w][p] == 5) five = true;
+        updateFive(w);
+    }
+    for (int i = 0; i < windowTables.sixesOfCount[idx]; ++i) {
+        int entry = windowTables.sixesOf[idx][i];
+        int w = entry >> 1;
+        if (entry & 1) {
+            ++sixEndCount[w][p];
+        } else {
+            ++sixInnerCount[w][p];
+        }
+        updateSix(w);
+    }
+    return five;
+}
+
+void ThreatIndex::remove(int idx, int p) {
+    for (int i = 0; i < windowTables.fivesOfCount[idx]; ++i) {
+        int w = windowTables.fivesOf[idx][i];
+        --fiveCount[w][p];
+        updateFive(w);
+    }
+    for (int i = 0; i < windowTables.sixesOfCount[idx]; ++i) {
+        int entry = windowTables.sixesOf[idx][i];
+        int w = entry >> 1;
+        if (entry & 1) {
+            --sixEndCount[w][p];
+        } else {
+            --sixInnerCount[w][p];
+        }
+        updateSix(w);
+    }
+}
+
+bool ThreatIndex::completesFive(int idx, int p) const {
+    for (int i = 0; i < windowTables.fivesOfCount[idx]; ++i) {
+        int w = windowTables.fivesOf[idx][i];
+        if (fiveCount[w][p] == 4 && fiveCount[w][1 - p] == 0) return true;
+    }
+    return false;
+}
+
+} // namespace gomoku
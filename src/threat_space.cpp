@@ -0,0 +1,185 @@
+// threat_space.cpp
+// VCF and VCT search over the threat queries of Board.
+
+#include "threat_space.h"
+
+#include <algorithm>
+
+#include "move_list.h"
+
+namespace gomoku {
+
+namespace {
+
+// Mixed into the cache key so that VCF and VCT results for the same
+// position do not collide.
+const uint64_t MODE_SALT[2] = {0ULL, 0x9E3779B97F4A7C15ULL};
+
+inline Move moveAt(int bit) {
+    return Move(bit % BOARD_STRIDE, bit / BOARD_STRIDE);
+}
+
+} // unnamed namespace
+
+ThreatSpaceSolver::ThreatSpaceSolver(int cacheBits)
+    : cache(static_cast<std::size_t>(1) << cacheBits),
+      cacheMask((static_cast<uint64_t>(1) << cacheBits) - 1),
+      nodes(0), nodeLimit(0), aborted(false) {
+    clear();
+}
+
+void ThreatSpaceSolver::clear() {
+    for (auto &e : cache) {
+        e.key = 0;
+        e.moves = -1;
+        e.proven = 0;
+        e.plies = 0;
+    }
+}
+
+bool ThreatSpaceSolver::probe(uint64_t key, int movesLeft, bool &win, int &plies) const {
+    const CacheEntry &e = cache[key & cacheMask];
+    if (e.key != key || e.moves < 0) return false;
+    // A win within fewer moves is still a win; a failure with more moves
+    // rules out a win with fewer.
+    if (e.proven && e.moves <= movesLeft) {
+        win = true;
+        plies = e.plies;
+        return true;
+    }
+    if (!e.proven && e.moves >= movesLeft) {
+        win = false;
+        return true;
+    }
+    return false;
+}
+
+void ThreatSpaceSolver::store(uint64_t key, int movesLeft, bool win, int plies) {
+    CacheEntry &e = cache[key & cacheMask];
+    e.key = key;
+    e.moves = static_cast<int8_t>(movesLeft);
+    e.proven = win ? 1 : 0;
+    e.plies = static_cast<int8_t>(std::min(plies, 127));
+}
+
+bool ThreatSpaceSolver::findVcf(Board &board, int maxMoves, int maxNodes, Move &move, int &plies) {
+    return find(board, VCF, maxMoves, maxNodes, move, plies);
+}
+
+bool ThreatSpaceSolver::findVct(Board &board, int maxMoves, int maxNodes, Move &move, int &plies) {
+    return find(board, VCT, maxMoves, maxNodes, move, plies);
+}
+
+bool ThreatSpaceSolver::find(Board &board, Mode mode, int maxMoves, int maxNodes,
+                             Move &move, int &plies) {
+    nodes = 0;
+    nodeLimit = maxNodes;
+    aborted = false;
+    if (board.hasWinner()) return false;
+    // Deepen one attacking move at a time, so the shortest win is found
+    // first; the cache makes the repeated shallow work cheap.
+    for (int moves = 1; moves <= maxMoves && !aborted; ++moves) {
+        if (attack(board, mode, moves, plies, &move)) return true;
+    }
+    return false;
+}
+
+bool ThreatSpaceSolver::attack(Board &board, Mode mode, int movesLeft, int &plies, Move *first) {
+    if (++nodes > nodeLimit) {
+        aborted = true;
+        return false;
+    }
+    Player attacker = board.sideToMove();
+    Player defender = opponentOf(attacker);
+    Bitboard fives = board.fivePoints(attacker);
+    if (fives.any()) {
+        plies = 1;
+        if (first != nullptr) fives.forEach([&](int bit) { *first = moveAt(bit); });
+        return true;
+    }
+    if (movesLeft <= 0) return false;
+    uint64_t key = board.getHashKey() ^ MODE_SALT[mode];
+    bool cachedWin;
+    if (first == nullptr && probe(key, movesLeft, cachedWin, plies)) {
+        return cachedWin;
+    }
+    // A four of the defender must be blocked at once.  The block keeps the
+    // attack going only if the attacker still has a threat afterwards,
+    // which the defender's node checks.
+    Bitboard blocks = board.fivePoints(defender);
+    MoveList moves;
+    if (blocks.any()) {
+        if (blocks.count() > 1) {
+            store(key, movesLeft, false, 0);
+            return false;
+        }
+        blocks.forEach([&](int bit) { moves.push_back(moveAt(bit)); });
+    } else {
+        // Fours first: they leave the defender a single reply.
+        Bitboard fours = board.fourPoints(attacker);
+        fours.forEach([&](int bit) { moves.push_back(moveAt(bit)); });
+        if (mode == VCT) {
+            board.threePoints(attacker).andNot(fours).forEach([&](int bit) {
+                moves.push_back(moveAt(bit));
+            });
+        }
+    }
+    for (const auto &m : moves) {
+        board.makeMove(m.x, m.y);
+        int sub = 0;
+        bool win = defend(board, mode, movesLeft - 1, sub);
+        board.unmakeMove(m.x, m.y);
+        if (win) {
+            plies = sub + 1;
+            if (first != nullptr) *first = m;
+            store(key, movesLeft, true, plies);
+            return true;
+        }
+        if (aborted) return false;
+    }
+    store(key, movesLeft, false, 0);
+    return false;
+}
+
+bool ThreatSpaceSolver::defend(Board &board, Mode mode, int movesLeft, int &plies) {
+    if (++nodes > nodeLimit) {
+        aborted = true;
+        return false;
+    }
+    Player defender = board.sideToMove();
+    Player attacker = opponentOf(defender);
+    // A defender who can complete five simply wins.
+    if (board.fivePoints(defender).any()) return false;
+    Bitboard fives = board.fivePoints(attacker);
+    Bitboard replies;
+    if (fives.any()) {
+        // Two different winning cells cannot both be blocked.
+        if (fives.count() > 1) {
+            plies = 2;
+            return true;
+        }
+        replies = fives;
+    } else {
+        if (mode == VCF) return false;
+        // Against live threes the defender may take any of their cells or
+        // counter with a four; every such reply must lose.
+        Bitboard defences = board.threeDefences(attacker);
+        if (!defences.any()) return false;
+        replies = defences | board.fourPoints(defender);
+    }
+    MoveList moves;
+    replies.forEach([&](int bit) { moves.push_back(moveAt(bit)); });
+    int longest = 0;
+    for (const auto &m : moves) {
+        board.makeMove(m.x, m.y);
+        int sub = 0;
+        bool win = attack(board, mode, movesLeft, sub, nullptr);
+        board.unmakeMove(m.x, m.y);
+        if (!win) return false;
+        longest = std::max(longest, sub);
+    }
+    plies = longest + 1;
+    return true;
+}
+
+} // namespace gomoku
@@ -0,0 +1,83 @@
+// time_manager.cpp
+// Iteration time predictions and stopping rules.
+
+#include "time_manager.h"
+
+#include <algorithm>
+
+namespace gomoku {
+
+namespace {
+
+// Bounds on the effective branching factor used for predictions; the
+// ratio of two short iterations is mostly timer noise.
+const double MIN_BRANCHING = 1.5;
+const double MAX_BRANCHING = 8.0;
+
+} // unnamed namespace
+
+TimeManager::TimeManager() {
+    start(0, 0);
+}
+
+void TimeManager::start(int ms, int cap) {
+    windowStart = Clock::now();
+    lastIteration = windowStart;
+    capMs = cap;
+    limitMs = std::min(ms, cap);
+    target = TARGET_SHARE * limitMs;
+    lastDurationMs = 0.0;
+    previousDurationMs = 0.0;
+    lastBest = Move(-1, -1);
+    lastScore = 0;
+    stableIterations = 0;
+    bestChanged = false;
+    scoreDropped = false;
+    forced = false;
+}
+
+void TimeManager::restart(int ms, int cap) {
+    windowStart = Clock::now();
+    capMs = cap;
+    limitMs = std::min(ms, cap);
+    target = TARGET_SHARE * limitMs;
+}
+
+double TimeManager::elapsedMs() const {
+    return std::chrono::duration<double, std::milli>(Clock::now() - windowStart).count();
+}
+
+void TimeManager::iterationDone(const Move &best, int score) {
+    Clock::time_point now = Clock::now();
+    previousDurationMs = lastDurationMs;
+    lastDurationMs = std::chrono::duration<double, std::milli>(now - lastIteration).count();
+    lastIteration = now;
+    bool first = lastBest.x < 0;
+    bestChanged = !first && (best.x != lastBest.x || best.y != lastBest.y);
+    scoreDropped = !first && score < lastScore - SCORE_DROP;
+    stableIterations = bestChanged || first ? 1 : stableIterations + 1;
+    lastBest = best;
+    lastScore = score;
+    if (bestChanged || scoreDropped) target += EXTEND_SHARE * (capMs - target);
+}
+
+bool TimeManager::startNextIteration() const {
+    double elapsed = elapsedMs();
+    if (elapsed >= target) return false;
+    if (!bestChanged && !scoreDropped) {
+        if (forced && elapsed >= FORCED_SHARE * limitMs) return false;
+        if (stableIterations >= STABLE_ITERATIONS && elapsed >= STABLE_SHARE * limitMs) {
+            return false;
+        }
+    }
+    // Predict the next iteration from the last one.
+    double branching = MAX_BRANCHING;
+    if (previousDurationMs > 0.0) {
+        branching = std::min(MAX_BRANCHING,
+                             std::max(MIN_BRANCHING, lastDurationMs / previousDurationMs));
+    }
+    double firstMove = FIRST_MOVE_SHARE * lastDurationMs * branching;
+    return elapsed + firstMove < capMs;
+}
+
+} // namespace gomoku
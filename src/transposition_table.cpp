@@ -0,0 +1,109 @@
+// transposition_table.cpp
+// Implementation of the fixed-size transposition table.
+
+#include "transposition_table.h"
+
+namespace gomoku {
+
+TranspositionTable::TranspositionTable(std::size_t sizeMb)
+    : bucketCount(0), bucketMask(0), generation(0) {
+    resize(sizeMb);
+}
+
+void TranspositionTable::resize(std::size_t sizeMb) {
+    // Round the bucket count down to a power of two so that the bucket
+    // index is a simple mask of the key.  Always keep at least one bucket.
+    std::size_t wanted = (sizeMb * 1024 * 1024) / sizeof(Bucket);
+    std::size_t count = 1;
+    while (count * 2 <= wanted) count *= 2;
+    buckets.reset();
+    buckets.reset(new Bucket[count]);
+    bucketCount = count;
+    bucketMask = static_cast<uint64_t>(count - 1);
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        for (int j = 0; j < BUCKET_ENTRIES; ++j) {
+            buckets[i].entries[j].check.store(0, std::memory_order_relaxed);
+            buckets[i].entries[j].data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+void TranspositionTable::newSearch() {
+    ++generation;
+}
+
+uint64_t TranspositionTable::pack(int score, uint8_t move, int depth, int bound, uint8_t gen) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(score))
+         | (static_cast<uint64_t>(move) << 32)
+         | (static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 40)
+         | (static_cast<uint64_t>(static_cast<uint8_t>(bound)) << 48)
+         | (static_cast<uint64_t>(gen) << 56);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry &out) const {
+    const Bucket &bucket = bucketFor(key);
+    for (int i = 0; i < BUCKET_ENTRIES; ++i) {
+        const Entry &e = bucket.entries[i];
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+        if (boundOf(data) != 0 && (check ^ data) == key) {
+            out.depth = depthOf(data);
+            out.score = scoreOf(data);
+            out.flag = boundOf(data) - 1;
+            uint8_t move = moveOf(data);
+            if (move == NO_MOVE) {
+                out.bestMove = Move(-1, -1);
+            } else {
+                out.bestMove = Move(move % 12, move / 12);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, int flag, const Move &bestMove) {
+    Bucket &bucket = bucketFor(key);
+    Entry *slot = nullptr;
+    uint64_t slotData = 0;
+    bool samePosition = false;
+    // Prefer the slot already holding this position; otherwise take an
+    // empty slot; otherwise evict the entry of least worth.  Worth grows
+    // with depth and shrinks by two plies per generation of age, so deep
+    // results from the current search survive while stale ones give way.
+    int worstWorth = 0;
+    for (int i = 0; i < BUCKET_ENTRIES; ++i) {
+        Entry &e = bucket.entries[i];
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+        if (boundOf(data) == 0 || (check ^ data) == key) {
+            slot = &e;
+            slotData = data;
+            samePosition = boundOf(data) != 0;
+            break;
+        }
+        int age = static_cast<uint8_t>(generation - generationOf(data));
+        int worth = depthOf(data) - 2 * age;
+        if (slot == nullptr || worth < worstWorth) {
+            slot = &e;
+            slotData = data;
+            worstWorth = worth;
+        }
+    }
+    uint8_t move = NO_MOVE;
+    if (bestMove.x >= 0 && bestMove.x < 12 && bestMove.y >= 0 && bestMove.y < 12) {
+        move = static_cast<uint8_t>(bestMove.y * 12 + bestMove.x);
+    } else if (samePosition) {
+        move = moveOf(slotData);
+    }
+    uint64_t data = pack(score, move, depth, flag + 1, generation);
+    slot->check.store(key ^ data, std::memory_order_relaxed);
+    slot->data.store(data, std::memory_order_relaxed);
+}
+
+} // namespace gomoku
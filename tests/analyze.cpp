@@ -0,0 +1,174 @@
+/**
+ * Streaming position analysis.
+ *
+ * Reads positions from a file or standard input and analyses them on a
+ * pool of engines (see analysis.h), writing one result line per position
+ * as soon as it is done:
+ *
+ *   cmake -S . -B build && cmake --build build --target analyze
+ *   ./build/analyze [--workers N] [--time MS] [--depth D] [--nodes N]
+ *                   [--tt MB] [FILE | -]
+ *
+ * or g++ -O2 -Iinclude src/[a-z]*.cpp tests/analyze.cpp -o analyze -lpthread
+ *
+ * An input line is either the format of tests/bench_positions.txt (a
+ * label, a colon, then the moves from the opening cross as "x y" pairs)
+ * or just the moves; empty lines and lines starting with '#' are skipped.
+ * Without a label a position is named by its input line number.  Each
+ * output line is
+ *
+ *   <label> move X Y score S depth D seldepth SD nodes N qnodes Q time MS pv X Y ...
+ *
+ * Results come in completion order, which with several workers differs
+ * from the input order; the label tells them apart.  The defaults are one
+ * worker per hardware thread, 1000 ms per position unless a depth or node
+ * limit is given, and 64 MB of transposition table shared out among the
+ * workers.  Progress and errors go to standard error.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "analysis.h"
+#include "board.h"
+
+using namespace gomoku;
+
+namespace {
+
+// Parse one input line; see the comment at the top of the file.
+bool parsePosition(const std::string &line, Board &board, std::string &label) {
+    std::size_t colon = line.find(':');
+    std::string moveText = line;
+    if (colon != std::string::npos) {
+        std::istringstream name(line.substr(0, colon));
+        name >> label;
+        moveText = line.substr(colon + 1);
+    }
+    std::istringstream moves(moveText);
+    std::vector<int> coords;
+    int c;
+    while (moves >> c) coords.push_back(c);
+    if (!moves.eof() || coords.size() % 2 != 0) return false;
+    for (std::size_t i = 0; i < coords.size(); i += 2) {
+        int x = coords[i], y = coords[i + 1];
+        if (x < 0 || x >= 12 || y < 0 || y >= 12 || board.hasWinner() || !board.makeMove(x, y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void usage(const char *program) {
+    std::cerr << "usage: " << program << " [--workers N] [--time MS] [--depth D] [--nodes N]"
+              << " [--tt MB] [FILE | -]\n";
+}
+
+} // unnamed namespace
+
+int main(int argc, char **argv) {
+    AnalysisOptions options;
+    options.workers = std::max(1u, std::thread::hardware_concurrency());
+    options.config.ttSizeMb = 64;
+    int timeMs = 0;
+    std::string path = "-";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--workers" && hasValue) {
+            options.workers = std::atoi(argv[++i]);
+        } else if (arg == "--time" && hasValue) {
+            timeMs = std::atoi(argv[++i]);
+        } else if (arg == "--depth" && hasValue) {
+            options.config.maxDepth = std::atoi(argv[++i]);
+        } else if (arg == "--nodes" && hasValue) {
+            options.config.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--tt" && hasValue) {
+            options.config.ttSizeMb = static_cast<std::size_t>(std::atoi(argv[++i]));
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            path = arg;
+        }
+    }
+    if (options.workers <= 0 || options.config.ttSizeMb == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    bool limited = options.config.maxDepth > 0 || options.config.maxNodes > 0;
+    // A depth or node limit decides alone; the clock only guards against
+    // a runaway search.
+    options.timeLimitMs = timeMs > 0 ? timeMs : limited ? 600000 : 1000;
+
+    std::ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            std::cerr << "cannot open " << path << "\n";
+            return 1;
+        }
+    }
+    std::istream &in = path == "-" ? std::cin : file;
+
+    // Labels of the positions in flight, by id.
+    std::unordered_map<uint64_t, std::string> labels;
+    std::mutex labelLock;
+    uint64_t nextId = 0;
+    uint64_t done = 0;
+    auto start = std::chrono::steady_clock::now();
+    BatchAnalyzer analyzer(options, [&](uint64_t id, const AnalysisResult &r) {
+        std::string label;
+        {
+            std::lock_guard<std::mutex> guard(labelLock);
+            auto it = labels.find(id);
+            label = it->second;
+            labels.erase(it);
+        }
+        const SearchStats &s = r.stats;
+        std::ostringstream line;
+        line << label << " move " << r.move.x << " " << r.move.y << " score " << r.score
+             << " depth " << s.depth << " seldepth " << s.seldepth << " nodes " << s.nodes
+             << " qnodes " << s.qnodes << " time " << static_cast<uint64_t>(s.elapsedMs)
+             << " pv";
+        for (int i = 0; i < r.pv.size(); ++i) line << " " << r.pv[i].x << " " << r.pv[i].y;
+        std::cout << line.str() << std::endl;
+        ++done;
+    });
+
+    std::string line;
+    int lineNo = 0;
+    bool ok = true;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#') continue;
+        Board board;
+        std::string label = std::to_string(lineNo);
+        if (!parsePosition(line, board, label)) {
+            std::cerr << path << ":" << lineNo << ": bad position\n";
+            ok = false;
+            continue;
+        }
+        uint64_t id = nextId++;
+        {
+            std::lock_guard<std::mutex> guard(labelLock);
+            labels[id] = label;
+        }
+        analyzer.submit(id, board);
+    }
+    analyzer.finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cerr << done << " positions in " << seconds << " s with " << options.workers
+              << " workers\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+/**
+ * Deterministic engine benchmark.
+ *
+ * Loads the position suite in tests/bench_positions.txt and searches every
+ * position with a fresh engine, to a fixed depth (default 6) or a fixed
+ * number of nodes, with one search thread or the --threads given.  Prints the nodes, time to depth and
+ * nodes per second of each search and of the whole suite, first with the
+ * pattern evaluation and then with the network of tests/network.nnue (or
+ * --network FILE; see network_eval.h), then times the board, threat and
+ * network primitives the search is built on:
+ *
+ *   cmake -S . -B build && cmake --build build --target bench
+ *   ./build/bench [--depth D | --nodes N] [--threads T] [--suite FILE]
+ *                 [--network FILE] [--search-only | --micro-only]
+ *
+ * or, without CMake,
+ *
+ *   g++ -O2 -Iinclude src/[a-z]*.cpp tests/bench.cpp -o bench -lpthread
+ *
+ * The node counts depend only on the code and the suite, never on the
+ * machine or its load, so the "signature" printed at the end (the total
+ * of all node counts) identifies the search exactly: a change that is
+ * meant to make the engine faster without changing its behaviour must
+ * keep the signature, and one that changes the search changes it.  This
+ * holds for one thread only: with more, the helpers' timing decides which
+ * entries they share through the transposition table, so node counts and
+ * the signature vary and only the times and NPS are comparable.  The
+ * network searches print a signature of their own, which also depends on
+ * the network file.  Only the times and NPS vary from run to run.  The
+ * micro-benchmarks print a checksum of their results for the same
+ * purpose.  The checked-in network is an untuned baseline that plays
+ * weaker than the patterns (see tests/network_train.cpp); it is searched
+ * for its speed, not its judgement.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "search.h"
+#include "threat_solver.h"
+
+using namespace gomoku;
+
+namespace {
+
+#ifdef GOMOKU_BENCH_SUITE
+const char *DEFAULT_SUITE = GOMOKU_BENCH_SUITE;
+#else
+const char *DEFAULT_SUITE = "tests/bench_positions.txt";
+#endif
+#ifdef GOMOKU_BENCH_NETWORK
+const char *DEFAULT_NETWORK = GOMOKU_BENCH_NETWORK;
+#else
+const char *DEFAULT_NETWORK = "tests/network.nnue";
+#endif
+const int DEFAULT_DEPTH = 6;
+// Passes over the suite made by each micro-benchmark.
+const int MICRO_ITERATIONS = 20000;
+
+struct Position {
+    std::string label;
+    Board board;
+    // Its candidate moves, for the micro-benchmarks.
+    std::vector<Move> candidates;
+};
+
+// Read the suite; see the comment at the top of the file for the format.
+bool loadSuite(const std::string &path, std::vector<Position> &out) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "cannot open " << path << "\n";
+        return false;
+    }
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(in, line)) {
+        ++lineNo;
+        if (line.empty() || line[0] == '#') continue;
+        std::size_t colon = line.find(':');
+        std::istringstream label(line.substr(0, colon));
+        Position p;
+        label >> p.label;
+        std::istringstream moves(colon == std::string::npos ? "" : line.substr(colon + 1));
+        std::vector<int> coords;
+        int c;
+        while (moves >> c) coords.push_back(c);
+        bool ok = colon != std::string::npos && moves.eof() && coords.size() % 2 == 0;
+        for (std::size_t j = 0; ok && j < coords.size(); j += 2) {
+            int x = coords[j], y = coords[j + 1];
+            ok = x >= 0 && x < 12 && y >= 0 && y < 12 && !p.board.hasWinner()
+                 && p.board.makeMove(x, y);
+        }
+        if (!ok) {
+            std::cerr << path << ":" << lineNo << ": bad position\n";
+            return false;
+        }
+        p.candidates = p.board.getCandidateMoves();
+        out.push_back(p);
+    }
+    return true;
+}
+
+struct SearchTotals {
+    uint64_t nodes = 0;
+    uint64_t qnodes = 0;
+    double ms = 0.0;
+};
+
+uint64_t searchNps(const SearchTotals &totals) {
+    return totals.ms > 0.0 ? static_cast<uint64_t>((totals.nodes + totals.qnodes) * 1000.0 / totals.ms)
+                           : 0;
+}
+
+// Search every position with the evaluator of base.
+void runSearches(std::vector<Position> &positions, int depth, uint64_t nodes,
+                 const SearchConfig &base, SearchTotals &totals) {
+    if (nodes > 0) {
+        std::cout << "search: " << nodes << " nodes per position";
+    } else {
+        std::cout << "search: depth " << depth;
+    }
+    if (base.threads > 1) std::cout << ", " << base.threads << " threads";
+    if (base.evaluator == Evaluator::Network) {
+        std::cout << ", network " << base.networkPath;
+    }
+    std::cout << "\n  pos  label        depth        nodes   qnodes       ms      nps  move\n";
+    for (int i = 0; i < static_cast<int>(positions.size()); ++i) {
+        SearchConfig config = base;
+        if (nodes > 0) {
+            config.maxNodes = nodes;
+        } else {
+            config.maxDepth = depth;
+        }
+        SearchEngine engine(config);
+        Board board = positions[i].board;
+        // The time limit only guards against a runaway search.
+        Move m = engine.findBestMove(board, board.sideToMove(), 600000);
+        const SearchStats &s = engine.lastSearchStats();
+        std::cout << "  " << std::setw(3) << i << "  " << std::left << std::setw(10)
+                  << positions[i].label << std::right << std::setw(7) << s.depth
+                  << std::setw(13) << s.nodes << std::setw(9) << s.qnodes
+                  << std::setw(9) << std::fixed << std::setprecision(1) << s.elapsedMs
+                  << std::setw(9) << static_cast<uint64_t>(s.nps())
+                  << "  " << m.x << "," << m.y << "\n";
+        totals.nodes += s.nodes;
+        totals.qnodes += s.qnodes;
+        totals.ms += s.elapsedMs;
+    }
+    std::cout << "  total: " << totals.nodes << " nodes, " << totals.qnodes << " qnodes, "
+              << std::setprecision(0) << totals.ms << " ms, " << searchNps(totals) << " nps\n";
+}
+
+// Time f over MICRO_ITERATIONS passes of the suite.  f returns the number
+// of operations it timed and adds its results to the checksum.
+template <typename F>
+void micro(const char *name, std::vector<Position> &positions, uint64_t &checksum, F f) {
+    uint64_t ops = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < MICRO_ITERATIONS; ++it) {
+        for (auto &p : positions) ops += f(p, checksum);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "  " << std::left << std::setw(22) << name << std::right
+              << std::setw(9) << std::fixed << std::setprecision(2)
+              << (ops > 0 ? ns / ops : 0.0) << " ns/op\n";
+}
+
+void runMicro(std::vector<Position> &positions, Network &network, uint64_t &checksum) {
+    std::cout << "micro: " << MICRO_ITERATIONS << " passes over the suite\n";
+    ThreatSolver solver;
+    micro("makeMove/unmakeMove", positions, checksum, [](Position &p, uint64_t &sum) {
+        for (const Move &m : p.candidates) {
+            p.board.makeMove(m.x, m.y);
+            sum += p.board.getHashKey();
+            p.board.unmakeMove(m.x, m.y);
+        }
+        return p.candidates.size();
+    });
+    micro("checkWin", positions, checksum, [](Position &p, uint64_t &sum) {
+        sum += p.board.checkWin(Player::Black) + 2 * p.board.checkWin(Player::White);
+        return 2;
+    });
+    micro("isWinningMove", positions, checksum, [](Position &p, uint64_t &sum) {
+        for (const Move &m : p.candidates) {
+            sum += p.board.isWinningMove(m.x, m.y, Player::Black)
+                 + 2 * p.board.isWinningMove(m.x, m.y, Player::White);
+        }
+        return 2 * p.candidates.size();
+    });
+    micro("getCandidateMoves", positions, checksum, [](Position &p, uint64_t &sum) {
+        sum += p.board.getCandidateMoves().size();
+        return 1;
+    });
+    micro("evaluate", positions, checksum, [](Position &p, uint64_t &sum) {
+        // What SearchEngine::evaluate() computes for the side to move.
+        Player us = p.board.sideToMove();
+        sum += static_cast<uint64_t>(p.board.lineScore(us) - p.board.lineScore(opponentOf(us)));
+        return 1;
+    });
+    micro("findBlockingMoves", positions, checksum, [&](Position &p, uint64_t &sum) {
+        ThreatSolver::ThreatList blocks;
+        solver.findBlockingMoves(p.board, p.board.sideToMove(), blocks);
+        sum += blocks.size();
+        if (!blocks.empty()) sum += blocks[0].severity;
+        return 1;
+    });
+    if (network.isOpen()) {
+        for (auto &p : positions) p.board.attachNetwork(&network);
+        micro("makeMove+network", positions, checksum, [](Position &p, uint64_t &sum) {
+            // As makeMove/unmakeMove, with the accumulators kept up to date.
+            for (const Move &m : p.candidates) {
+                p.board.makeMove(m.x, m.y);
+                sum += static_cast<uint16_t>(p.board.accumulator().values[0][0]);
+                p.board.unmakeMove(m.x, m.y);
+            }
+            return p.candidates.size();
+        });
+        micro("network evaluate", positions, checksum, [](Position &p, uint64_t &sum) {
+            sum += static_cast<uint64_t>(p.board.networkScore(p.board.sideToMove()));
+            return 1;
+        });
+        network.setKernel(NetworkKernel::Scalar);
+        micro("network evaluate (C)", positions, checksum, [](Position &p, uint64_t &sum) {
+            // The portable kernel; adds the same to the checksum.
+            sum += static_cast<uint64_t>(p.board.networkScore(p.board.sideToMove()));
+            return 1;
+        });
+        network.setKernel(NetworkKernel::Auto);
+        for (auto &p : positions) p.board.attachNetwork(nullptr);
+    }
+    std::cout << "  checksum " << checksum << "\n";
+}
+
+} // unnamed namespace
+
+int main(int argc, char **argv) {
+    int depth = DEFAULT_DEPTH;
+    uint64_t nodes = 0;
+    int threads = 1;
+    std::string suite = DEFAULT_SUITE;
+    std::string networkPath = DEFAULT_NETWORK;
+    bool search = true, microBenchmarks = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--depth") == 0 && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--nodes") == 0 && i + 1 < argc) {
+            nodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--suite") == 0 && i + 1 < argc) {
+            suite = argv[++i];
+        } else if (std::strcmp(argv[i], "--network") == 0 && i + 1 < argc) {
+            networkPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--search-only") == 0) {
+            microBenchmarks = false;
+        } else if (std::strcmp(argv[i], "--micro-only") == 0) {
+            search = false;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--depth D | --nodes N] [--threads T]"
+                      << " [--suite FILE] [--network FILE] [--search-only | --micro-only]\n";
+            return 2;
+        }
+    }
+    std::vector<Position> positions;
+    if (!loadSuite(suite, positions) || positions.empty()) return 1;
+    std::cout << positions.size() << " positions from " << suite << "\n";
+    Network network;
+    if (!network.open(networkPath)) {
+        std::cout << "cannot load network " << networkPath << "; pattern evaluation only\n";
+    }
+    if (search) {
+        SearchConfig base;
+        base.threads = threads;
+        SearchTotals totals;
+        runSearches(positions, depth, nodes, base, totals);
+        std::cout << "signature " << totals.nodes + totals.qnodes << "\n";
+        if (network.isOpen()) {
+            SearchConfig config = base;
+            config.evaluator = Evaluator::Network;
+            config.networkPath = networkPath;
+            SearchTotals networkTotals;
+            runSearches(positions, depth, nodes, config, networkTotals);
+            std::cout << "network signature " << networkTotals.nodes + networkTotals.qnodes << "\n"
+                      << "nps: pattern " << searchNps(totals) << ", network "
+                      << searchNps(networkTotals) << "\n";
+        }
+    }
+    if (microBenchmarks) {
+        uint64_t checksum = 0;
+        runMicro(positions, network, checksum);
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * Opening book generator.
+ *
+ * Writes a book file in the format of opening_book.h from one of two
+ * sources:
+ *
+ *   g++ -O2 -Iinclude src/[a-z]*.cpp tests/book_gen.cpp -o book_gen -lpthread
+ *   ./book_gen selfplay <out.book> [games] [plies] [depth] [seed]
+ *   ./book_gen text <in.txt> <out.book>
+ *
+ * selfplay plays games of the engine against itself at a fixed depth, so
+ * that the result does not depend on the machine.  Each game starts with
+ * up to two seeded random moves near the centre, then records the
+ * position key, the chosen move and the search score of every engine move
+ * among the first plies plies (default: 20 games, 12 plies, depth 7, seed
+ * 1).  A move played in several games gets the number of games as its
+ * weight.  Records are keyed canonically (see opening_book.h), so games
+ * reaching symmetric positions add up.
+ *
+ * text reads analysis output, one position per line:
+ *
+ *   x y x y ... : x y [weight [score]]
+ *
+ * The moves before the colon are played from the opening cross; the move
+ * after it is the book move for the resulting position.  The default
+ * weight is 1 and the default score 0.  Empty lines and lines starting
+ * with '#' are skipped.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "opening_book.h"
+#include "search.h"
+
+using namespace gomoku;
+
+namespace {
+
+int selfPlay(const std::string &out, int games, int plies, int depth, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::vector<BookRecord> records;
+    SearchConfig config;
+    config.maxDepth = depth;
+    SearchEngine black(config);
+    SearchEngine white(config);
+    for (int g = 0; g < games; ++g) {
+        Board board;
+        int randomMoves = static_cast<int>(rng() % 3);
+        for (int i = 0; i < randomMoves; ++i) {
+            int x, y;
+            do {
+                x = 3 + static_cast<int>(rng() % 6);
+                y = 3 + static_cast<int>(rng() % 6);
+            } while (board.isOccupied(x, y));
+            board.makeMove(x, y);
+        }
+        for (int ply = randomMoves; ply < plies && !board.hasWinner(); ++ply) {
+            Player side = board.sideToMove();
+            SearchEngine &engine = side == Player::Black ? black : white;
+            // The depth limit ends the search; the time limit only guards
+            // against a pathological position.
+            Move m = engine.findBestMove(board, side, 600000);
+            if (m.x < 0 || board.isOccupied(m.x, m.y)) break;
+            records.push_back(OpeningBook::makeRecord(board, m, 1, engine.lastSearchStats().score));
+            board.makeMove(m.x, m.y);
+        }
+        std::cerr << "game " << g + 1 << "/" << games << ", " << records.size() << " records\n";
+    }
+    if (!OpeningBook::write(out, records)) {
+        std::cerr << "cannot write " << out << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int fromText(const std::string &in, const std::string &out) {
+    std::ifstream file(in);
+    if (!file) {
+        std::cerr << "cannot read " << in << "\n";
+        return 1;
+    }
+    std::vector<BookRecord> records;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (line.empty() || line[0] == '#') continue;
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            std::cerr << in << ":" << lineNumber << ": missing ':'\n";
+            return 1;
+        }
+        Board board;
+        std::istringstream moves(line.substr(0, colon));
+        int x, y;
+        bool legal = true;
+        while (moves >> x >> y) {
+            if (!board.makeMove(x, y)) legal = false;
+        }
+        std::istringstream bookMove(line.substr(colon + 1));
+        int weight = 1;
+        int score = 0;
+        int value;
+        if (!(bookMove >> x >> y) || !legal || board.isOccupied(x, y)
+            || x < 0 || x >= 12 || y < 0 || y >= 12) {
+            std::cerr << in << ":" << lineNumber << ": illegal move\n";
+            return 1;
+        }
+        if (bookMove >> value) {
+            weight = std::max(1, std::min(value, 0xFFFF));
+            if (bookMove >> value) score = value;
+        }
+        records.push_back(OpeningBook::makeRecord(board, Move(x, y), weight, score));
+    }
+    if (!OpeningBook::write(out, records)) {
+        std::cerr << "cannot write " << out << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+} // unnamed namespace
+
+int main(int argc, char **argv) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    if (mode == "selfplay" && argc > 2) {
+        int games = argc > 3 ? std::atoi(argv[3]) : 20;
+        int plies = argc > 4 ? std::atoi(argv[4]) : 12;
+        int depth = argc > 5 ? std::atoi(argv[5]) : 7;
+        unsigned seed = argc > 6 ? static_cast<unsigned>(std::atoi(argv[6])) : 1;
+        return selfPlay(argv[2], games, plies, depth, seed);
+    }
+    if (mode == "text" && argc > 3) {
+        return fromText(argv[2], argv[3]);
+    }
+    std::cerr << "usage: book_gen selfplay <out.book> [games] [plies] [depth] [seed]\n"
+              << "       book_gen text <in.txt> <out.book>\n";
+    return 2;
+}
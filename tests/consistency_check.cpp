@@ -0,0 +1,447 @@
+/**
+ * Consistency checks for the incrementally maintained state of Board.
+ *
+ * Plays seeded random games, taking back about one move in four, and after
+ * every move and take-back compares what Board keeps up to date against a
+ * recomputation from the stones alone:
+ *   * the threat queries (fivePoints, fourPoints, threePoints,
+ *     threeDefences, isWinningMove and checkWin) against a scan of every
+ *     five- and six-cell window of the board;
+ *   * lineScore against scoreLine applied to every line of the board;
+ *   * scorePlacements with the scalar and the AVX2 kernel against each
+ *     other and against makeMove, lineScore and unmakeMove;
+ *   * symmetricKey(t), for the four symmetries that keep the opening
+ *     cross, against getHashKey() of a board holding the transformed
+ *     stones, and canonicalKey against the smallest of the eight keys;
+ *   * the network accumulators, updated with either kernel, against a
+ *     refresh from the stones with the other, and the scalar and AVX2
+ *     network evaluations against each other, with seeded random weights.
+ * It also checks every entry of the line code table that a line of the
+ * board can produce against scoreLine of the decoded cells, and the
+ * whole-board operations of bitboard.h (boardMask, stepBack, stepForward,
+ * containsFive, neighbourhood and openThreeStarts) against a cell-by-cell
+ * scan on random sets of cells, in whichever layout it is built for.
+ * Prints one
+ * line per check and exits with status 1 if any check finds a
+ * mismatch.  CTest runs it as the consistency_check test:
+ *
+ *   g++ -O2 -Iinclude src/[a-z]*.cpp tests/consistency_check.cpp -o consistency_check -lpthread
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bitboard.h"
+#include "board.h"
+#include "line_geometry.h"
+#include "network_eval.h"
+#include "pattern_eval.h"
+#include "placement_eval.h"
+#include "symmetry.h"
+
+using namespace gomoku;
+
+namespace {
+
+const int NUM_GAMES = 400;
+const int MAX_PLIES = 70;
+
+Bitboard cellBit(int cell) {
+    Bitboard b = Bitboard::none();
+    int bit = bitIndex(cell % 12, cell / 12);
+    b.w[bit >> 6] |= 1ULL << (bit & 63);
+    return b;
+}
+
+bool sameBits(const Bitboard &a, const Bitboard &b) {
+    return a.w[0] == b.w[0] && a.w[1] == b.w[1] && a.w[2] == b.w[2];
+}
+
+// Runs one check over the random games and reports its result.
+class Check {
+public:
+    explicit Check(const char *name) : name(name), comparisons(0), failures(0) {}
+
+    // Record the outcome of one comparison; the first few mismatches are
+    // described on stderr.
+    void expect(bool ok, const char *what) {
+        ++comparisons;
+        if (ok) return;
+        if (failures < 10) std::cerr << name << ": " << what << " differs\n";
+        ++failures;
+    }
+
+    // Call f(board) on every position of NUM_GAMES seeded random games,
+    // with network attached to the boards if it is not null.  f may make
+    // and unmake moves but must leave the position unchanged.
+    template <typename F>
+    void playouts(uint32_t seed, F f, const Network *network = nullptr) {
+        std::mt19937 rng(seed);
+        for (int g = 0; g < NUM_GAMES; ++g) {
+            Board board;
+            if (network != nullptr) board.attachNetwork(network);
+            for (int ply = 0; ply < MAX_PLIES && !board.hasWinner(); ++ply) {
+                auto moves = board.getCandidateMoves();
+                const Move m = moves[rng() % moves.size()];
+                board.makeMove(m.x, m.y);
+                f(board);
+                if (rng() % 4 == 0) {
+                    board.unmakeMove(m.x, m.y);
+                    f(board);
+                }
+            }
+        }
+    }
+
+    // Print the result; true if every comparison matched.
+    bool report() const {
+        std::cout << name << ": " << comparisons << " comparisons, "
+                  << (failures == 0 ? "ok" : "FAILED") << "\n";
+        return failures == 0;
+    }
+
+private:
+    const char *name;
+    long comparisons;
+    long failures;
+};
+
+// --- Threat queries ---
+
+struct Threats {
+    Bitboard five[2], four[2], three[2], defence[2];
+    bool won[2];
+};
+
+// The threat sets of both players, from the windows of every line.
+Threats scanThreats(const Board &board) {
+    Threats t;
+    for (int p = 0; p < 2; ++p) {
+        t.five[p] = t.four[p] = t.three[p] = t.defence[p] = Bitboard::none();
+        t.won[p] = false;
+    }
+    for (int line = 0; line < NUM_LINES; ++line) {
+        const int *cells = LINE_GEOMETRY.cells[line];
+        int state[MAX_LINE_LENGTH];
+        for (int i = 0; i < LINE_GEOMETRY.length[line]; ++i) {
+            state[i] = board.getCellState(cells[i] % 12, cells[i] / 12);
+        }
+        for (int s = 0; s + 5 <= LINE_GEOMETRY.length[line]; ++s) {
+            int count[3] = {0, 0, 0};
+            for (int i = s; i < s + 5; ++i) ++count[state[i]];
+            for (int p = 0; p < 2; ++p) {
+                if (count[2 - p] != 0) continue;
+                int own = count[1 + p];
+                if (own == 5) t.won[p] = true;
+                if (own != 3 && own != 4) continue;
+                for (int i = s; i < s + 5; ++i) {
+                    if (state[i] != 0) continue;
+                    Bitboard &set = own == 4 ? t.five[p] : t.four[p];
+                    set = set | cellBit(cells[i]);
+                }
+            }
+        }
+        for (int s = 0; s + 6 <= LINE_GEOMETRY.length[line]; ++s) {
+            if (state[s] != 0 || state[s + 5] != 0) continue;
+            int count[3] = {0, 0, 0};
+            for (int i = s + 1; i < s + 5; ++i) ++count[state[i]];
+            for (int p = 0; p < 2; ++p) {
+                if (count[2 - p] != 0) continue;
+                int own = count[1 + p];
+                if (own != 2 && own != 3) continue;
+                Bitboard cellsOf = Bitboard::none();
+                for (int i = s + 1; i < s + 5; ++i) {
+                    if (state[i] == 0) cellsOf = cellsOf | cellBit(cells[i]);
+                }
+                if (own == 2) {
+                    t.three[p] = t.three[p] | cellsOf;
+                } else {
+                    t.defence[p] = t.defence[p] | cellsOf | cellBit(cells[s])
+                                 | cellBit(cells[s + 5]);
+                }
+            }
+        }
+    }
+    return t;
+}
+
+bool checkThreats() {
+    Check check("threat queries");
+    check.playouts(1401, [&](const Board &board) {
+        Threats t = scanThreats(board);
+        for (int p = 0; p < 2; ++p) {
+            Player player = static_cast<Player>(p);
+            check.expect(sameBits(board.fivePoints(player), t.five[p]), "fivePoints");
+            check.expect(sameBits(board.fourPoints(player), t.four[p]), "fourPoints");
+            check.expect(sameBits(board.threePoints(player), t.three[p]), "threePoints");
+            check.expect(sameBits(board.threeDefences(player), t.defence[p]), "threeDefences");
+            check.expect(board.checkWin(player) == t.won[p], "checkWin");
+            for (int cell = 0; cell < 144; ++cell) {
+                int x = cell % 12, y = cell / 12;
+                if (board.isOccupied(x, y)) continue;
+                check.expect(board.isWinningMove(x, y, player)
+                             == t.five[p].test(bitIndex(x, y)), "isWinningMove");
+            }
+        }
+    });
+    return check.report();
+}
+
+// --- Line scores ---
+
+// Sum of scoreLine over every line for the player with cell code own.
+int scanLineScore(const Board &board, int own) {
+    int total = 0;
+    for (int line = 0; line < NUM_LINES; ++line) {
+        int8_t states[MAX_LINE_LENGTH];
+        for (int i = 0; i < LINE_GEOMETRY.length[line]; ++i) {
+            int cell = LINE_GEOMETRY.cells[line][i];
+            states[i] = static_cast<int8_t>(board.getCellState(cell % 12, cell / 12));
+        }
+        total += scoreLine(states, LINE_GEOMETRY.length[line], own);
+    }
+    return total;
+}
+
+bool checkLineScores() {
+    Check check("line scores");
+    check.playouts(301, [&](const Board &board) {
+        check.expect(board.lineScore(Player::Black) == scanLineScore(board, 1), "black lineScore");
+        check.expect(board.lineScore(Player::White) == scanLineScore(board, 2), "white lineScore");
+    });
+    return check.report();
+}
+
+// --- Placement scores ---
+
+bool checkPlacements() {
+    Check check(placementAvx2Available() ? "placement kernels"
+                                         : "placement kernels (no AVX2, scalar only)");
+    std::vector<int> cells;
+    std::vector<int> scalar, avx2;
+    check.playouts(1701, [&](Board &board) {
+        if (board.hasWinner()) return;
+        Player player = board.sideToMove();
+        Player opponent = opponentOf(player);
+        cells.clear();
+        for (const Move &m : board.getCandidateMoves()) cells.push_back(m.y * 12 + m.x);
+        int count = static_cast<int>(cells.size());
+        scalar.assign(count, 0);
+        avx2.assign(count, 0);
+        board.scorePlacements(player, cells.data(), count, scalar.data(), PlacementKernel::Scalar);
+        board.scorePlacements(player, cells.data(), count, avx2.data(), PlacementKernel::Avx2);
+        for (int i = 0; i < count; ++i) {
+            int x = cells[i] % 12, y = cells[i] / 12;
+            board.makeMove(x, y);
+            int made = board.lineScore(player) - board.lineScore(opponent);
+            board.unmakeMove(x, y);
+            check.expect(scalar[i] == made, "scalar kernel");
+            check.expect(avx2[i] == made, "AVX2 kernel");
+        }
+    });
+    return check.report();
+}
+
+// --- Symmetric keys ---
+
+bool isOpeningCell(int cell) {
+    return cell == 5 * 12 + 5 || cell == 5 * 12 + 6 || cell == 6 * 12 + 5 || cell == 6 * 12 + 6;
+}
+
+// A board holding the stones of board mapped by symmetry t, which must
+// keep the opening cross, reached by alternating the stones of each
+// colour from a fresh board.
+Board transformedBoard(const Board &board, int t) {
+    std::vector<int> stones[2];
+    for (int cell = 0; cell < 144; ++cell) {
+        int code = board.getCellState(cell % 12, cell / 12);
+        if (code != 0 && !isOpeningCell(cell)) stones[code - 1].push_back(SYMMETRY.cellOf[t][cell]);
+    }
+    Board image;
+    for (std::size_t i = 0; i < stones[0].size(); ++i) {
+        image.makeMove(stones[0][i] % 12, stones[0][i] / 12);
+        if (i < stones[1].size()) image.makeMove(stones[1][i] % 12, stones[1][i] / 12);
+    }
+    return image;
+}
+
+bool checkSymmetricKeys() {
+    Check check("symmetric keys");
+    const int CROSS_SYMMETRIES[] = {0, 1, 6, 7};
+    check.playouts(2201, [&](const Board &board) {
+        for (int t : CROSS_SYMMETRIES) {
+            check.expect(board.symmetricKey(t) == transformedBoard(board, t).getHashKey(),
+                         "symmetricKey");
+        }
+        int transform;
+        uint64_t canonical = board.canonicalKey(transform);
+        bool smallest = canonical == board.symmetricKey(transform);
+        for (int t = 0; t < NUM_SYMMETRIES; ++t) smallest = smallest && canonical <= board.symmetricKey(t);
+        check.expect(smallest, "canonicalKey");
+    });
+    return check.report();
+}
+
+// --- Network ---
+
+// Weights drawn so that accumulator values fall on both sides of the
+// clipping range of the hidden layers.
+std::vector<NetworkWeights> randomWeights(uint32_t seed) {
+    std::mt19937 rng(seed);
+    auto draw = [&](int lo, int hi) { return lo + static_cast<int>(rng() % (hi - lo + 1)); };
+    std::vector<NetworkWeights> weights(1);
+    NetworkWeights &w = weights[0];
+    for (auto &v : w.ftBias) v = static_cast<int16_t>(draw(-50, 150));
+    for (auto &row : w.ftWeights) {
+        for (auto &v : row) v = static_cast<int16_t>(draw(-150, 150));
+    }
+    for (auto &v : w.l2Bias) v = draw(-10000, 10000);
+    for (auto &row : w.l2Weights) {
+        for (auto &v : row) v = static_cast<int8_t>(draw(-128, 127));
+    }
+    w.outBias = draw(-1000, 1000);
+    for (auto &v : w.outWeights) v = static_cast<int8_t>(draw(-128, 127));
+    return weights;
+}
+
+bool checkNetwork() {
+    Check check(networkAvx2Available() ? "network kernels"
+                                       : "network kernels (no AVX2, scalar only)");
+    std::vector<NetworkWeights> weights = randomWeights(3001);
+    Network networks[2];
+    networks[0].assign(weights[0]);
+    networks[0].setKernel(NetworkKernel::Scalar);
+    networks[1].assign(weights[0]);
+    networks[1].setKernel(NetworkKernel::Avx2);
+    for (int k = 0; k < 2; ++k) {
+        const Network &other = networks[1 - k];
+        check.playouts(3002 + k, [&](const Board &board) {
+            int8_t cells[144];
+            for (int cell = 0; cell < 144; ++cell) {
+                cells[cell] = static_cast<int8_t>(board.getCellState(cell % 12, cell / 12));
+            }
+            NetworkAccumulator fresh;
+            other.refresh(fresh, cells);
+            check.expect(std::memcmp(&fresh, &board.accumulator(), sizeof(fresh)) == 0,
+                         "accumulator");
+            for (int side = 0; side < 2; ++side) {
+                check.expect(board.networkScore(static_cast<Player>(side))
+                             == other.evaluate(fresh, side), "evaluation");
+            }
+        }, &networks[k]);
+    }
+    return check.report();
+}
+
+// --- Line code table ---
+
+// Every code of a line of length cells, whose cells beyond the end are
+// digit 2, against scoreLine of the cells themselves.
+void checkCodesOfLength(Check &check, int length) {
+    int padding = 0;
+    for (int i = length; i < LINE_CODE_CELLS; ++i) padding += 2 * lineCodeWeight(i);
+    int8_t states[LINE_CODE_CELLS] = {};
+    int count = lineCodeWeight(length - 1) * 3;
+    for (int n = 0; n < count; ++n) {
+        int code = padding;
+        for (int i = 0, rest = n; i < length; ++i, rest /= 3) {
+            states[i] = static_cast<int8_t>(rest % 3);
+            code += states[i] * lineCodeWeight(i);
+        }
+        check.expect(lineCodeScore(code) == scoreLine(states, length, 1), "lineCodeScore");
+    }
+}
+
+bool checkLineCodeTable() {
+    Check check("line code table");
+    for (int length = 1; length <= MAX_LINE_LENGTH; ++length) checkCodesOfLength(check, length);
+    return check.report();
+}
+
+// --- Bitboard operations ---
+
+const int DX[NUM_DIRECTIONS] = {1, 0, 1, -1};
+const int DY[NUM_DIRECTIONS] = {0, 1, 1, 1};
+
+bool onBoard(int x, int y) {
+    return x >= 0 && x < 12 && y >= 0 && y < 12;
+}
+
+// True if b holds (x,y), which may lie off the board.
+bool holds(const Bitboard &b, int x, int y) {
+    return onBoard(x, y) && b.test(bitIndex(x, y));
+}
+
+// Each cell is in the set with probability density / 16.
+Bitboard randomCells(std::mt19937 &rng, int density) {
+    Bitboard b = Bitboard::none();
+    for (int cell = 0; cell < 144; ++cell) {
+        if (static_cast<int>(rng() % 16) < density) b = b | cellBit(cell);
+    }
+    return b;
+}
+
+bool checkBitboardOperations() {
+    Check check("bitboard operations");
+    Bitboard all = Bitboard::none();
+    for (int cell = 0; cell < 144; ++cell) all = all | cellBit(cell);
+    check.expect(sameBits(boardMask(), all), "boardMask");
+    std::mt19937 rng(501);
+    for (int n = 0; n < 20000; ++n) {
+        Bitboard own = randomCells(rng, 1 + n % 12);
+        Bitboard empty = boardMask().andNot(own | randomCells(rng, 4));
+        bool five = false;
+        Bitboard back[NUM_DIRECTIONS], forward[NUM_DIRECTIONS];
+        Bitboard near = Bitboard::none(), threes = Bitboard::none();
+        for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+            back[dir] = forward[dir] = Bitboard::none();
+        }
+        for (int cell = 0; cell < 144; ++cell) {
+            int x = cell % 12, y = cell / 12;
+            for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+                int dx = DX[dir], dy = DY[dir];
+                if (holds(own, x + dx, y + dy)) back[dir] = back[dir] | cellBit(cell);
+                if (holds(own, x - dx, y - dy)) forward[dir] = forward[dir] | cellBit(cell);
+                int run = 0;
+                while (run < 5 && holds(own, x + run * dx, y + run * dy)) ++run;
+                if (run == 5) five = true;
+                if (holds(empty, x, y) && holds(own, x + dx, y + dy)
+                    && holds(own, x + 2 * dx, y + 2 * dy) && holds(own, x + 3 * dx, y + 3 * dy)
+                    && holds(empty, x + 4 * dx, y + 4 * dy)) {
+                    threes = threes | cellBit(cell);
+                }
+            }
+            if (own.test(bitIndex(x, y))) continue;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    if (holds(own, x + dx, y + dy)) near = near | cellBit(cell);
+                }
+            }
+        }
+        for (int dir = 0; dir < NUM_DIRECTIONS; ++dir) {
+            check.expect(sameBits(stepBack(own, dir), back[dir]), "stepBack");
+            check.expect(sameBits(stepForward(own, dir), forward[dir]), "stepForward");
+        }
+        check.expect(containsFive(own) == five, "containsFive");
+        check.expect(sameBits(neighbourhood(own), near), "neighbourhood");
+        check.expect(sameBits(openThreeStarts(own, empty), threes), "openThreeStarts");
+    }
+    return check.report();
+}
+
+} // unnamed namespace
+
+int main() {
+    bool ok = true;
+    ok &= checkThreats();
+    ok &= checkLineScores();
+    ok &= checkPlacements();
+    ok &= checkSymmetricKeys();
+    ok &= checkNetwork();
+    ok &= checkLineCodeTable();
+    ok &= checkBitboardOperations();
+    return ok ? 0 : 1;
+}
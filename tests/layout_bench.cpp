@@ -0,0 +1,101 @@
+/**
+ * Micro-benchmark for the bitboard layouts.
+ *
+ * Builds a fixed set of positions from seeded random playouts and times
+ * the whole-board bitboard operations (five detection, neighbourhood,
+ * open-three masks), candidate generation and makeMove/unmakeMove on them.
+ * The layout is chosen at compile time, so the program is built twice to
+ * compare the dense 12-column layout with the padded 13-column one:
+ *
+ *   g++ -O2 -Iinclude src/[a-z]*.cpp tests/layout_bench.cpp -o layout_bench
+ *   g++ -O2 -DGOMOKU_PADDED_BITBOARD -Iinclude src/[a-z]*.cpp \
+ *       tests/layout_bench.cpp -o layout_bench_padded
+ *
+ * Every result feeds a checksum that is printed at the end; both builds
+ * must report the same checksum.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "bitboard.h"
+#include "board.h"
+
+using namespace gomoku;
+
+namespace {
+
+const int NUM_POSITIONS = 256;
+const int ITERATIONS = 2000;
+
+// Play a seeded number of random moves near the existing stones.
+std::vector<Board> makePositions() {
+    std::vector<Board> positions;
+    std::mt19937 rng(12345);
+    for (int i = 0; i < NUM_POSITIONS; ++i) {
+        Board board;
+        int plies = 4 + static_cast<int>(rng() % 40);
+        for (int p = 0; p < plies && !board.hasWinner(); ++p) {
+            auto moves = board.getCandidateMoves();
+            const Move &m = moves[rng() % moves.size()];
+            board.makeMove(m.x, m.y);
+        }
+        positions.push_back(board);
+    }
+    return positions;
+}
+
+template <typename F>
+void run(const char *name, std::vector<Board> &positions, uint64_t &checksum, F f) {
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < ITERATIONS; ++it) {
+        for (auto &board : positions) {
+            checksum = checksum * 31 + static_cast<uint64_t>(f(board));
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << "  " << name << ": "
+              << ns / (static_cast<double>(ITERATIONS) * positions.size())
+              << " ns/op\n";
+}
+
+} // unnamed namespace
+
+int main() {
+    std::vector<Board> positions = makePositions();
+    uint64_t checksum = 0;
+    std::cout << "Bitboard layout: stride " << BOARD_STRIDE
+#ifdef GOMOKU_PADDED_BITBOARD
+              << " (padded)\n";
+#else
+              << " (dense)\n";
+#endif
+    run("containsFive x2", positions, checksum, [](Board &b) {
+        return containsFive(b.stones(Player::Black)) + 2 * containsFive(b.stones(Player::White));
+    });
+    run("neighbourhood", positions, checksum, [](Board &b) {
+        return neighbourhood(b.occupied()).count();
+    });
+    run("openThreeStarts x2", positions, checksum, [](Board &b) {
+        Bitboard empty = b.emptyCells();
+        return openThreeStarts(b.stones(Player::Black), empty).count()
+             + openThreeStarts(b.stones(Player::White), empty).count();
+    });
+    run("getCandidateMoves", positions, checksum, [](Board &b) {
+        return static_cast<int>(b.getCandidateMoves().size());
+    });
+    run("makeMove/unmakeMove", positions, checksum, [](Board &b) {
+        auto moves = b.getCandidateMoves();
+        const Move &m = moves[moves.size() / 2];
+        b.makeMove(m.x, m.y);
+        int score = b.lineScore(Player::Black) - b.lineScore(Player::White);
+        b.unmakeMove(m.x, m.y);
+        return score;
+    });
+    std::cout << "checksum " << checksum << "\n";
+    return 0;
+}
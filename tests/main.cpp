@@ -1,12 +1,93 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <sstream>
+#include <thread>
 
 #include "board.h"
 #include "search.h"
 
 using namespace gomoku;
 
+namespace {
+
+// Time limit of a real search, in milliseconds.
+const int MOVE_TIME_MS = 1800;
+// A ponder search runs until the opponent moves; this limit only ends
+// one that is never stopped.
+const int PONDER_TIME_MS = 10 * 60 * 1000;
+
+// Background search on the opponent's time.  After we move, start()
+// guesses the opponent's reply from the transposition table and searches
+// our answer to it on a separate thread while the main thread keeps
+// reading commands.  When the opponent's move arrives, opponentMoved()
+// either lets the search continue as the real one, with the normal time
+// limit counted from now (a ponder hit), or stops it; in both cases the
+// table stays warm for the next search.
+class Ponderer {
+public:
+    explicit Ponderer(SearchEngine &engine) : engine(engine), active(false), hit(false) {}
+    ~Ponderer() { cancel(); }
+
+    void start(const Board &board, Player myColor) {
+        cancel();
+        if (board.hasWinner() || !engine.expectedMove(board, guess)) return;
+        ponderBoard = board;
+        ponderBoard.makeMove(guess.x, guess.y);
+        if (ponderBoard.hasWinner()) return;
+        engine.resetStop();
+        active = true;
+        hit = false;
+        thread = std::thread([this, myColor] {
+            result = engine.findBestMove(ponderBoard, myColor, PONDER_TIME_MS);
+        });
+    }
+
+    // The opponent played (x,y).
+    void opponentMoved(int x, int y) {
+        if (!active) return;
+        if (!hit && x == guess.x && y == guess.y) {
+            hit = true;
+            engine.setDeadline(MOVE_TIME_MS);
+        } else {
+            cancel();
+        }
+    }
+
+    // If the running search is a ponder hit, wait for it and return true
+    // with its move.
+    bool takeResult(Move &move) {
+        if (!active || !hit) {
+            cancel();
+            return false;
+        }
+        thread.join();
+        active = false;
+        move = result;
+        return true;
+    }
+
+    void cancel() {
+        if (!active) return;
+        engine.stop();
+        thread.join();
+        active = false;
+    }
+
+private:
+    SearchEngine &engine;
+    std::thread thread;
+    Board ponderBoard;
+    Move guess;
+    Move result;
+    bool active;
+    bool hit;
+};
+
+} // unnamed namespace
+
 // Entry point for the Gomoku engine implementing the competition protocol.
 // The engine reads commands from standard input and outputs responses to
 // standard output.  Supported commands are:
@@ -16,9 +97,38 @@ using namespace gomoku;
 //   TURN            – It is our turn to move; output our move as "x y".
 //   END <field>     – The game has ended; <field> indicates the winner.
 //   DEBUG ...       – A debug command; ignored by this implementation.
-int main() {
+//
+// With --stats the engine prints the statistics of every search (see
+// search_stats.h) to standard error after choosing a move.  With
+// --stats=debug it sends them to the manager instead, as a line
+// "DEBUG <stats>" on standard output before the move.  --book <file> loads
+// an opening book (see opening_book.h).  --network <file> evaluates with
+// a network (see network_eval.h) instead of the line patterns.  --ponder
+// keeps searching on the opponent's time (see Ponderer).  --threads N
+// searches with N threads (SearchConfig::threads, default 1).
+int main(int argc, char **argv) {
+    enum { STATS_OFF, STATS_STDERR, STATS_DEBUG } statsOutput = STATS_OFF;
+    SearchConfig config;
+    bool ponder = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--stats") == 0) {
+            statsOutput = STATS_STDERR;
+        } else if (std::strcmp(argv[i], "--stats=debug") == 0) {
+            statsOutput = STATS_DEBUG;
+        } else if (std::strcmp(argv[i], "--book") == 0 && i + 1 < argc) {
+            config.bookPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--network") == 0 && i + 1 < argc) {
+            config.evaluator = Evaluator::Network;
+            config.networkPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--ponder") == 0) {
+            ponder = true;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            config.threads = std::max(1, std::atoi(argv[++i]));
+        }
+    }
     Board board;
-    SearchEngine engine;
+    SearchEngine engine(config);
+    Ponderer ponderer(engine);
     Player myColor = Player::Black;
     std::string token;
     while (std::cin >> token) {
@@ -27,6 +137,7 @@ int main() {
             if (!(std::cin >> field)) break;
             // field == 1 -> we are black; field == 2 -> we are white
             myColor = (field == 1 ? Player::Black : Player::White);
+            ponderer.cancel();
             // Reset the board to the initial predetermined state.
             board = Board();
             std::cout << "OK" << std::endl;
@@ -34,11 +145,21 @@ int main() {
         } else if (token == "PLACE") {
             int x, y;
             if (!(std::cin >> x >> y)) break;
+            ponderer.opponentMoved(x, y);
             board.makeMove(x, y);
         } else if (token == "TURN") {
-            // Compute and output our move.
-            // Use a time limit of 1800 milliseconds per move.
-            Move myMove = engine.findBestMove(board, myColor, 1800);
+            // Compute and output our move, unless the ponder search has
+            // already been searching this position.
+            Move myMove;
+            if (!ponderer.takeResult(myMove)) {
+                engine.resetStop();
+                myMove = engine.findBestMove(board, myColor, MOVE_TIME_MS);
+            }
+            if (statsOutput == STATS_STDERR) {
+                std::cerr << engine.lastSearchStats() << std::endl;
+            } else if (statsOutput == STATS_DEBUG) {
+                std::cout << "DEBUG " << engine.lastSearchStats() << std::endl;
+            }
             if (myMove.x < 0 || myMove.y < 0) {
                 // Fallback: if no move found, pick the first candidate.
                 auto candidates = board.getCandidateMoves();
@@ -52,7 +173,9 @@ int main() {
             board.makeMove(myMove.x, myMove.y);
             std::cout << myMove.x << " " << myMove.y << std::endl;
             std::cout.flush();
+            if (ponder) ponderer.start(board, myColor);
         } else if (token == "END") {
+            ponderer.cancel();
             int field;
             if (std::cin >> field) {
                 // Game ended; we could log results or reset.
@@ -0,0 +1,441 @@
+/**
+ * Trainer of evaluation networks.
+ *
+ * Fits the network of network_eval.h to positions dumped by the
+ * tournament runner and writes it as a weights file:
+ *
+ *   ./build/tournament --games 8000 --a depth=4 --b depth=4 --opening-plies 4 \
+ *       --dump samples.bin
+ *   ./build/network_train samples.bin out.nnue [--epochs E] [--batch B] [--lr LR]
+ *                         [--lambda L] [--scale K] [--seed S]
+ *
+ * or g++ -O2 -Iinclude src/[a-z]*.cpp tests/network_train.cpp -o network_train -lpthread
+ *
+ * The network is trained in floating point with the layout and value
+ * ranges of the quantised one, so that rounding its weights loses little:
+ * activations are clipped to [0, 1] and the weights of the hidden and
+ * output layers are kept within what their int8 encodings can hold.  The
+ * target of a position is a blend of the search's verdict and the game's
+ * outcome for the side to move,
+ *
+ *   target = (1 - L) * sigmoid(score / K) + L * (result + 1) / 2
+ *
+ * with L = 0.5 and K = 100000 (an open three, see pattern_eval.h) by
+ * default, and the loss is the squared difference between it and the
+ * sigmoid of the network's output.  Duplicate positions are dropped, and
+ * every position is used under a random one of the four symmetries that
+ * keep the opening cross, a fresh one each epoch.  One position in twenty
+ * is held out; after each epoch the trainer prints the loss on the rest
+ * and on the held-out positions, and at the end the held-out loss of the
+ * quantised network as the engine computes it.  Training is single
+ * threaded and deterministic for a given seed and input.
+ *
+ * tests/network.nnue, the network the bench searches with, was trained
+ * with the defaults and 40 epochs on 32000 games at depth 4 with 4 to 8
+ * random opening plies.  It is an untuned baseline, clearly weaker than
+ * the pattern evaluation: at depth 4 it scored +64 -131 =5 against it
+ * (-121 Elo, 95% interval [-174, -73]), and at 100 ms a move +42 -52 =6
+ * (-35 +/- 67 Elo).  It is there to measure the network's speed and to
+ * start training from, not to play with.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "network_eval.h"
+#include "symmetry.h"
+
+using namespace gomoku;
+
+namespace {
+
+// Scores at least this large are proven wins (see search.cpp).
+const int WIN_BOUND = 90000000;
+// Largest magnitude of the first layer weights, so that 144 stones and
+// the bias cannot overflow the int16 accumulator.
+const float FT_LIMIT = 1.5f;
+const float L2_LIMIT = 127.0f / NETWORK_L2_SCALE;
+const float OUT_LIMIT = 127.0f / NETWORK_OUT_SCALE;
+// Symmetries that keep the opening cross (see symmetry.h).
+const int CROSS_SYMMETRIES[4] = {0, 1, 6, 7};
+
+const int FT_SIZE = NETWORK_INPUTS * NETWORK_HIDDEN;
+const int L2_INPUTS = 2 * NETWORK_HIDDEN;
+
+// Floating point parameters, all in one array for the optimiser.
+struct Parameters {
+    std::vector<float> values;
+    float *ftBias;
+    float *ftWeights;   // [NETWORK_INPUTS][NETWORK_HIDDEN]
+    float *l2Bias;
+    float *l2Weights;   // [NETWORK_L2][L2_INPUTS]
+    float *outBias;
+    float *outWeights;
+
+    Parameters()
+        : values(NETWORK_HIDDEN + FT_SIZE + NETWORK_L2 + NETWORK_L2 * L2_INPUTS + 1 + NETWORK_L2,
+                 0.0f) {
+        float *p = values.data();
+        ftBias = p;
+        p += NETWORK_HIDDEN;
+        ftWeights = p;
+        p += FT_SIZE;
+        l2Bias = p;
+        p += NETWORK_L2;
+        l2Weights = p;
+        p += NETWORK_L2 * L2_INPUTS;
+        outBias = p;
+        p += 1;
+        outWeights = p;
+    }
+    Parameters(const Parameters &) = delete;
+    Parameters &operator=(const Parameters &) = delete;
+};
+
+struct Example {
+    // Active inputs of the side to move's and the opponent's perspective.
+    std::vector<int> features[2];
+    float target;
+};
+
+float sigmoid(float x) {
+    return 1.0f / (1.0f + std::exp(-x));
+}
+
+// The example of sample s under symmetry t.
+Example makeExample(const NetworkSample &s, int t, float lambda, float scale) {
+    Example e;
+    int side = s.side;
+    for (int colour = 0; colour < 2; ++colour) {
+        for (int cell = 0; cell < 144; ++cell) {
+            if (((s.stones[colour][cell / 64] >> (cell % 64)) & 1) == 0) continue;
+            int image = SYMMETRY.cellOf[t][cell];
+            e.features[0].push_back(networkFeature(side, colour, image));
+            e.features[1].push_back(networkFeature(1 - side, colour, image));
+        }
+    }
+    float verdict;
+    if (s.score >= WIN_BOUND) {
+        verdict = 1.0f;
+    } else if (s.score <= -WIN_BOUND) {
+        verdict = 0.0f;
+    } else {
+        verdict = sigmoid(static_cast<float>(s.score) / scale);
+    }
+    e.target = (1.0f - lambda) * verdict + lambda * 0.5f * (s.result + 1);
+    return e;
+}
+
+// Activations of one forward pass, kept for the backward pass.
+struct Pass {
+    float acc[2][NETWORK_HIDDEN];
+    float input[L2_INPUTS];
+    float hiddenSum[NETWORK_L2];
+    float hidden[NETWORK_L2];
+    float output;
+};
+
+float clip(float v) {
+    return std::min(std::max(v, 0.0f), 1.0f);
+}
+
+void forward(const Parameters &p, const Example &e, Pass &pass) {
+    for (int persp = 0; persp < 2; ++persp) {
+        float *acc = pass.acc[persp];
+        std::copy(p.ftBias, p.ftBias + NETWORK_HIDDEN, acc);
+        for (int f : e.features[persp]) {
+            const float *row = p.ftWeights + f * NETWORK_HIDDEN;
+            for (int i = 0; i < NETWORK_HIDDEN; ++i) acc[i] += row[i];
+        }
+        for (int i = 0; i < NETWORK_HIDDEN; ++i) {
+            pass.input[persp * NETWORK_HIDDEN + i] = clip(acc[i]);
+        }
+    }
+    float out = *p.outBias;
+    for (int j = 0; j < NETWORK_L2; ++j) {
+        const float *row = p.l2Weights + j * L2_INPUTS;
+        float sum = p.l2Bias[j];
+        for (int i = 0; i < L2_INPUTS; ++i) sum += row[i] * pass.input[i];
+        pass.hiddenSum[j] = sum;
+        pass.hidden[j] = clip(sum);
+        out += p.outWeights[j] * pass.hidden[j];
+    }
+    pass.output = out;
+}
+
+// Add the gradient of the loss of e to grad; returns the loss.
+float backward(const Parameters &p, const Example &e, std::vector<float> &grad) {
+    Pass pass;
+    forward(p, e, pass);
+    float predicted = sigmoid(pass.output);
+    float error = predicted - e.target;
+    float dOut = 2.0f * error * predicted * (1.0f - predicted);
+
+    float *g = grad.data();
+    float *gFtBias = g;
+    float *gFtWeights = gFtBias + NETWORK_HIDDEN;
+    float *gL2Bias = gFtWeights + FT_SIZE;
+    float *gL2Weights = gL2Bias + NETWORK_L2;
+    float *gOutBias = gL2Weights + NETWORK_L2 * L2_INPUTS;
+    float *gOutWeights = gOutBias + 1;
+
+    *gOutBias += dOut;
+    float dInput[L2_INPUTS] = {};
+    for (int j = 0; j < NETWORK_L2; ++j) {
+        gOutWeights[j] += dOut * pass.hidden[j];
+        float s = pass.hiddenSum[j];
+        if (s <= 0.0f || s >= 1.0f) continue;
+        float dHidden = dOut * p.outWeights[j];
+        gL2Bias[j] += dHidden;
+        const float *row = p.l2Weights + j * L2_INPUTS;
+        float *gRow = gL2Weights + j * L2_INPUTS;
+        for (int i = 0; i < L2_INPUTS; ++i) {
+            gRow[i] += dHidden * pass.input[i];
+            dInput[i] += dHidden * row[i];
+        }
+    }
+    for (int persp = 0; persp < 2; ++persp) {
+        float dAcc[NETWORK_HIDDEN];
+        for (int i = 0; i < NETWORK_HIDDEN; ++i) {
+            float a = pass.acc[persp][i];
+            dAcc[i] = a > 0.0f && a < 1.0f ? dInput[persp * NETWORK_HIDDEN + i] : 0.0f;
+            gFtBias[i] += dAcc[i];
+        }
+        for (int f : e.features[persp]) {
+            float *gRow = gFtWeights + f * NETWORK_HIDDEN;
+            for (int i = 0; i < NETWORK_HIDDEN; ++i) gRow[i] += dAcc[i];
+        }
+    }
+    return error * error;
+}
+
+float loss(const Parameters &p, const Example &e) {
+    Pass pass;
+    forward(p, e, pass);
+    float error = sigmoid(pass.output) - e.target;
+    return error * error;
+}
+
+// Adam with the usual constants.
+struct Adam {
+    std::vector<float> m, v;
+    float rate;
+    int steps = 0;
+
+    Adam(std::size_t size, float learningRate) : m(size, 0.0f), v(size, 0.0f), rate(learningRate) {}
+
+    void step(std::vector<float> &values, const std::vector<float> &grad) {
+        const float beta1 = 0.9f, beta2 = 0.999f, epsilon = 1e-8f;
+        ++steps;
+        float c1 = 1.0f - std::pow(beta1, static_cast<float>(steps));
+        float c2 = 1.0f - std::pow(beta2, static_cast<float>(steps));
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            m[i] = beta1 * m[i] + (1.0f - beta1) * grad[i];
+            v[i] = beta2 * v[i] + (1.0f - beta2) * grad[i] * grad[i];
+            values[i] -= rate * (m[i] / c1) / (std::sqrt(v[i] / c2) + epsilon);
+        }
+    }
+};
+
+void clampRange(float *values, int count, float limit) {
+    for (int i = 0; i < count; ++i) values[i] = std::min(std::max(values[i], -limit), limit);
+}
+
+void clampParameters(Parameters &p) {
+    clampRange(p.ftBias, NETWORK_HIDDEN, FT_LIMIT);
+    clampRange(p.ftWeights, FT_SIZE, FT_LIMIT);
+    clampRange(p.l2Weights, NETWORK_L2 * L2_INPUTS, L2_LIMIT);
+    clampRange(p.outWeights, NETWORK_L2, OUT_LIMIT);
+}
+
+template <typename Out>
+Out quantise(float v, float scale) {
+    return static_cast<Out>(std::lround(v * scale));
+}
+
+void quantiseParameters(const Parameters &p, NetworkWeights &w) {
+    for (int i = 0; i < NETWORK_HIDDEN; ++i) {
+        w.ftBias[i] = quantise<int16_t>(p.ftBias[i], NETWORK_FT_SCALE);
+    }
+    for (int f = 0; f < NETWORK_INPUTS; ++f) {
+        for (int i = 0; i < NETWORK_HIDDEN; ++i) {
+            w.ftWeights[f][i] = quantise<int16_t>(p.ftWeights[f * NETWORK_HIDDEN + i], NETWORK_FT_SCALE);
+        }
+    }
+    for (int j = 0; j < NETWORK_L2; ++j) {
+        w.l2Bias[j] = quantise<int32_t>(p.l2Bias[j], NETWORK_FT_SCALE * NETWORK_L2_SCALE);
+        for (int i = 0; i < L2_INPUTS; ++i) {
+            w.l2Weights[j][i] = quantise<int8_t>(p.l2Weights[j * L2_INPUTS + i], NETWORK_L2_SCALE);
+        }
+        w.outWeights[j] = quantise<int8_t>(p.outWeights[j], NETWORK_OUT_SCALE);
+    }
+    w.outBias = quantise<int32_t>(*p.outBias, NETWORK_FT_SCALE * NETWORK_OUT_SCALE);
+}
+
+// Held-out loss of the quantised network, with its integer kernels.
+double quantisedLoss(const Network &network, const std::vector<NetworkSample> &samples,
+                     float lambda, float scale) {
+    double total = 0.0;
+    for (const NetworkSample &s : samples) {
+        int8_t cells[144];
+        for (int cell = 0; cell < 144; ++cell) {
+            cells[cell] = 0;
+            for (int colour = 0; colour < 2; ++colour) {
+                if ((s.stones[colour][cell / 64] >> (cell % 64)) & 1) cells[cell] = colour + 1;
+            }
+        }
+        NetworkAccumulator acc;
+        network.refresh(acc, cells);
+        float output = static_cast<float>(network.evaluate(acc, s.side)) / NETWORK_EVAL_SCALE;
+        float error = sigmoid(output) - makeExample(s, 0, lambda, scale).target;
+        total += error * error;
+    }
+    return samples.empty() ? 0.0 : total / samples.size();
+}
+
+bool readSamples(const std::string &path, std::vector<NetworkSample> &out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    NetworkSample s;
+    while (in.read(reinterpret_cast<char *>(&s), sizeof(s))) out.push_back(s);
+    return true;
+}
+
+// Hash of a sample's position, to drop duplicates.
+uint64_t sampleKey(const NetworkSample &s) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL * (s.side + 1);
+    for (int colour = 0; colour < 2; ++colour) {
+        for (int w = 0; w < 3; ++w) {
+            h ^= s.stones[colour][w] + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+        }
+    }
+    return h;
+}
+
+void usage(const char *program) {
+    std::cerr << "usage: " << program << " SAMPLES OUT [--epochs E] [--batch B] [--lr LR]"
+              << " [--lambda L] [--scale K] [--seed S]\n";
+}
+
+} // unnamed namespace
+
+int main(int argc, char **argv) {
+    int epochs = 20;
+    int batch = 256;
+    float rate = 0.001f;
+    float lambda = 0.5f;
+    float scale = 100000.0f;
+    uint64_t seed = 1;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--epochs" && hasValue) {
+            epochs = std::atoi(argv[++i]);
+        } else if (arg == "--batch" && hasValue) {
+            batch = std::atoi(argv[++i]);
+        } else if (arg == "--lr" && hasValue) {
+            rate = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--lambda" && hasValue) {
+            lambda = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--scale" && hasValue) {
+            scale = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.size() != 2 || epochs <= 0 || batch <= 0 || scale <= 0.0f) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<NetworkSample> all;
+    if (!readSamples(paths[0], all)) {
+        std::cerr << "cannot read " << paths[0] << "\n";
+        return 1;
+    }
+    std::vector<NetworkSample> training, heldOut;
+    std::unordered_set<uint64_t> seen;
+    for (const NetworkSample &s : all) {
+        if (!seen.insert(sampleKey(s)).second) continue;
+        (seen.size() % 20 == 0 ? heldOut : training).push_back(s);
+    }
+    std::cout << all.size() << " samples, " << training.size() << " training, "
+              << heldOut.size() << " held out\n";
+    if (training.empty()) return 1;
+
+    std::mt19937_64 rng(seed);
+    Parameters params;
+    {
+        std::uniform_real_distribution<float> ft(-0.05f, 0.05f);
+        std::normal_distribution<float> l2(0.0f, 1.0f / std::sqrt(static_cast<float>(L2_INPUTS)));
+        std::normal_distribution<float> out(0.0f, 1.0f / std::sqrt(static_cast<float>(NETWORK_L2)));
+        for (int i = 0; i < NETWORK_HIDDEN; ++i) params.ftBias[i] = 0.25f;
+        for (int i = 0; i < FT_SIZE; ++i) params.ftWeights[i] = ft(rng);
+        for (int j = 0; j < NETWORK_L2; ++j) params.l2Bias[j] = 0.25f;
+        for (int i = 0; i < NETWORK_L2 * L2_INPUTS; ++i) params.l2Weights[i] = l2(rng);
+        for (int j = 0; j < NETWORK_L2; ++j) params.outWeights[j] = out(rng);
+        clampParameters(params);
+    }
+    std::vector<Example> validation;
+    for (const NetworkSample &s : heldOut) validation.push_back(makeExample(s, 0, lambda, scale));
+
+    Adam adam(params.values.size(), rate);
+    std::vector<float> grad(params.values.size());
+    std::vector<std::size_t> order(training.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    for (int epoch = 1; epoch <= epochs; ++epoch) {
+        std::shuffle(order.begin(), order.end(), rng);
+        double trainLoss = 0.0;
+        for (std::size_t start = 0; start < order.size(); start += batch) {
+            std::size_t end = std::min(order.size(), start + static_cast<std::size_t>(batch));
+            std::fill(grad.begin(), grad.end(), 0.0f);
+            for (std::size_t k = start; k < end; ++k) {
+                int t = CROSS_SYMMETRIES[rng() % 4];
+                Example e = makeExample(training[order[k]], t, lambda, scale);
+                trainLoss += backward(params, e, grad);
+            }
+            float n = static_cast<float>(end - start);
+            for (float &g : grad) g /= n;
+            adam.step(params.values, grad);
+            clampParameters(params);
+        }
+        double validLoss = 0.0;
+        for (const Example &e : validation) validLoss += loss(params, e);
+        std::cout << "epoch " << epoch << std::fixed << std::setprecision(5)
+                  << "  train " << trainLoss / training.size()
+                  << "  held out " << (validation.empty() ? 0.0 : validLoss / validation.size())
+                  << std::endl;
+    }
+
+    NetworkWeights weights;
+    quantiseParameters(params, weights);
+    if (!Network::write(paths[1], weights)) {
+        std::cerr << "cannot write " << paths[1] << "\n";
+        return 1;
+    }
+    Network network;
+    if (!network.open(paths[1])) {
+        std::cerr << "cannot read back " << paths[1] << "\n";
+        return 1;
+    }
+    std::cout << "quantised held out " << std::setprecision(5)
+              << quantisedLoss(network, heldOut, lambda, scale) << "\n"
+              << "wrote " << paths[1] << "\n";
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * Fixed-depth search benchmark.
+ *
+ * Builds a set of positions from seeded random playouts and searches each
+ * one to the same depth twice: once with plain alpha–beta, where every move
+ * is searched with the node's full window, and once with principal
+ * variation search and root aspiration windows.  Prints the nodes and time
+ * of both searches per position and in total:
+ *
+ *   g++ -O2 -Iinclude src/[a-z]*.cpp tests/search_bench.cpp -o search_bench -lpthread
+ *   ./search_bench [depth]
+ *
+ * Positions that the engine answers without searching (an urgent block)
+ * are skipped.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "board.h"
+#include "search.h"
+
+using namespace gomoku;
+
+namespace {
+
+const int NUM_POSITIONS = 24;
+const int DEFAULT_DEPTH = 4;
+
+// Play a seeded number of random moves near the existing stones.
+std::vector<Board> makePositions() {
+    std::vector<Board> positions;
+    std::mt19937 rng(2024);
+    while (static_cast<int>(positions.size()) < NUM_POSITIONS) {
+        Board board;
+        int plies = 2 + static_cast<int>(rng() % 20);
+        for (int p = 0; p < plies && !board.hasWinner(); ++p) {
+            auto moves = board.getCandidateMoves();
+            const Move &m = moves[rng() % moves.size()];
+            board.makeMove(m.x, m.y);
+        }
+        if (!board.hasWinner()) positions.push_back(board);
+    }
+    return positions;
+}
+
+struct Result {
+    uint64_t nodes;
+    double ms;
+    Move move;
+};
+
+Result searchToDepth(const Board &position, bool pvs, int depth) {
+    SearchConfig config;
+    config.pvs = pvs;
+    config.maxDepth = depth;
+    SearchEngine engine(config);
+    Board board = position;
+    auto start = std::chrono::steady_clock::now();
+    // The time limit only guards against a runaway search.
+    Move m = engine.findBestMove(board, board.sideToMove(), 600000);
+    auto end = std::chrono::steady_clock::now();
+    return {engine.nodesSearched(),
+            std::chrono::duration<double, std::milli>(end - start).count(), m};
+}
+
+} // unnamed namespace
+
+int main(int argc, char **argv) {
+    int depth = argc > 1 ? std::atoi(argv[1]) : DEFAULT_DEPTH;
+    std::vector<Board> positions = makePositions();
+    uint64_t totalPlain = 0, totalPvs = 0;
+    double msPlain = 0, msPvs = 0;
+    int searched = 0, sameMove = 0;
+    std::cout << "depth " << depth << "\n";
+    std::cout << "pos  alphabeta-nodes       ms    pvs-nodes       ms\n";
+    for (int i = 0; i < static_cast<int>(positions.size()); ++i) {
+        Result plain = searchToDepth(positions[i], false, depth);
+        if (plain.nodes == 0) continue;
+        Result pvs = searchToDepth(positions[i], true, depth);
+        std::cout << i << "  " << plain.nodes << "  " << plain.ms
+                  << "  " << pvs.nodes << "  " << pvs.ms << "\n";
+        totalPlain += plain.nodes;
+        totalPvs += pvs.nodes;
+        msPlain += plain.ms;
+        msPvs += pvs.ms;
+        ++searched;
+        if (plain.move.x == pvs.move.x && plain.move.y == pvs.move.y) ++sameMove;
+    }
+    std::cout << "positions " << searched << ", same move " << sameMove << "\n";
+    std::cout << "alpha-beta: " << totalPlain << " nodes, " << msPlain << " ms\n";
+    std::cout << "pvs:        " << totalPvs << " nodes, " << msPvs << " ms\n";
+    if (totalPlain > 0) {
+        std::cout << "node ratio  " << static_cast<double>(totalPvs) / totalPlain << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,430 @@
+/**
+ * Headless self-play tournament between two engine configurations.
+ *
+ * Plays games between engine A and engine B on a pool of worker threads,
+ * each game with its own pair of SearchEngine instances, and reports the
+ * score, an Elo estimate and, if asked, a sequential probability ratio
+ * test:
+ *
+ *   cmake -S . -B build && cmake --build build --target tournament
+ *   ./build/tournament [options]
+ *
+ * or g++ -O2 -Iinclude src/[a-z]*.cpp tests/tournament.cpp -o tournament -lpthread
+ *
+ *   --games N          games to play (default 100)
+ *   --concurrency C    games played at once (default: hardware threads)
+ *   --a SETTINGS       settings of engine A (see below)
+ *   --b SETTINGS       settings of engine B
+ *   --opening-plies K  random moves after the opening cross (default 2)
+ *   --seed S           seed of the random openings (default 1)
+ *   --out FILE         append a record of every game to FILE
+ *   --dump FILE        append every position an engine searched, with its
+ *                      score and the game's result, to FILE as training
+ *                      data (NetworkSample, see network_eval.h)
+ *   --sprt E0 E1       stop once an SPRT of H0: elo = E0 against
+ *                      H1: elo = E1 (A's Elo advantage) accepts one of them,
+ *                      with alpha = beta = 0.05
+ *
+ * SETTINGS is a comma-separated list of key=value pairs.  time=MS, depth=D
+ * and nodes=N limit every move; depth and nodes make the games independent
+ * of the machine's speed and load.  Without any of them a move gets 100 ms;
+ * with only depth or nodes the clock is kept out of the way.  The other
+ * keys are the SearchConfig fields of the same names: ttSizeMb,
+ * persistentTT, keepHistory, historyDecay, threads, pvs, maxDepth (same as
+ * depth), maxNodes (same as nodes), adaptiveTime, moveTimeCapMs,
+ * threatSpace, quiescence, lateMoveReductions, moveCountPruningDepth,
+ * symmetricTT, bookPath and networkPath, and evaluator=pattern or
+ * evaluator=network.  For example
+ *
+ *   ./build/tournament --games 2000 --a depth=6 --b depth=6,pvs=0 --sprt 0 10
+ *
+ * Games come in pairs: both play the same random opening, with A as black
+ * in the first game and as white in the second, which cancels most of the
+ * first-move advantage and the luck of the opening.  A game that fills the
+ * board is a draw; an engine that returns an illegal move loses.  With
+ * time limits, keep the concurrency at or below the number of cores, or
+ * the engines get less time than they are given.
+ *
+ * Each game record is one line:
+ *
+ *   <game> <black> <white> <result> : x y x y ...
+ *
+ * where black and white are A or B, the result is 1-0, 0-1 or 1/2-1/2 and
+ * the moves are those played from the opening cross, random opening moves
+ * included.  The move list has the format of tests/bench_positions.txt.
+ * Lines are written as games finish, so their order varies, as do the
+ * games in the dump.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "board.h"
+#include "search.h"
+
+using namespace gomoku;
+
+namespace {
+
+struct EngineSettings {
+    SearchConfig config;
+    // Time per move; 0 for the default.
+    int timeMs = 0;
+
+    int moveTimeMs() const {
+        if (timeMs > 0) return timeMs;
+        // Depth and node limits should decide, not the clock.
+        return config.maxDepth > 0 || config.maxNodes > 0 ? 600000 : 100;
+    }
+};
+
+bool parseBool(const std::string &value, bool &out) {
+    if (value == "1" || value == "true") {
+        out = true;
+    } else if (value == "0" || value == "false") {
+        out = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Parse a SETTINGS string; returns false on an unknown key or bad value.
+bool parseSettings(const std::string &text, EngineSettings &out) {
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        if (item.empty()) continue;
+        std::size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = item.substr(0, eq);
+        std::string value = item.substr(eq + 1);
+        SearchConfig &c = out.config;
+        char *end = nullptr;
+        long long n = std::strtoll(value.c_str(), &end, 10);
+        bool isNumber = !value.empty() && *end == '\0' && n >= 0;
+        if (key == "time" && isNumber) {
+            out.timeMs = static_cast<int>(n);
+        } else if ((key == "depth" || key == "maxDepth") && isNumber) {
+            c.maxDepth = static_cast<int>(n);
+        } else if ((key == "nodes" || key == "maxNodes") && isNumber) {
+            c.maxNodes = static_cast<uint64_t>(n);
+        } else if (key == "ttSizeMb" && isNumber && n > 0) {
+            c.ttSizeMb = static_cast<std::size_t>(n);
+        } else if (key == "moveTimeCapMs" && isNumber) {
+            c.moveTimeCapMs = static_cast<int>(n);
+        } else if (key == "historyDecay" && isNumber && n > 0) {
+            c.historyDecay = static_cast<int>(n);
+        } else if (key == "threads" && isNumber && n > 0) {
+            c.threads = static_cast<int>(n);
+        } else if (key == "bookPath") {
+            c.bookPath = value;
+        } else if (key == "networkPath") {
+            c.networkPath = value;
+        } else if (key == "evaluator") {
+            if (value == "pattern") {
+                c.evaluator = Evaluator::Pattern;
+            } else if (value == "network") {
+                c.evaluator = Evaluator::Network;
+            } else {
+                return false;
+            }
+        } else if (key == "persistentTT") {
+            if (!parseBool(value, c.persistentTT)) return false;
+        } else if (key == "keepHistory") {
+            if (!parseBool(value, c.keepHistory)) return false;
+        } else if (key == "pvs") {
+            if (!parseBool(value, c.pvs)) return false;
+        } else if (key == "adaptiveTime") {
+            if (!parseBool(value, c.adaptiveTime)) return false;
+        } else if (key == "threatSpace") {
+            if (!parseBool(value, c.threatSpace)) return false;
+        } else if (key == "moveCountPruningDepth" && isNumber) {
+            c.moveCountPruningDepth = static_cast<int>(n);
+        } else if (key == "lateMoveReductions") {
+            if (!parseBool(value, c.lateMoveReductions)) return false;
+        } else if (key == "quiescence") {
+            if (!parseBool(value, c.quiescence)) return false;
+        } else if (key == "symmetricTT") {
+            if (!parseBool(value, c.symmetricTT)) return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Result of a game from black's point of view: 1 win, 0 draw, -1 loss.
+struct GameRecord {
+    int result;
+    std::vector<Move> moves;
+    // The positions the engines searched, for --dump; the results are
+    // filled in when the game ends.
+    std::vector<NetworkSample> samples;
+};
+
+NetworkSample makeSample(const Board &board, int score) {
+    NetworkSample s;
+    std::memset(&s, 0, sizeof(s));
+    for (int cell = 0; cell < 144; ++cell) {
+        int state = board.getCellState(cell % 12, cell / 12);
+        if (state != 0) s.stones[state - 1][cell / 64] |= 1ULL << (cell % 64);
+    }
+    s.score = score;
+    s.side = static_cast<int8_t>(board.sideToMove());
+    s.ply = static_cast<int16_t>(board.countStones(Player::Black) + board.countStones(Player::White));
+    return s;
+}
+
+// Random moves near the stones, from a generator seeded by the pair, so
+// that both games of a pair start alike.
+void playOpening(Board &board, std::vector<Move> &moves, int plies, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    for (int p = 0; p < plies && !board.hasWinner(); ++p) {
+        std::vector<Move> candidates = board.getCandidateMoves();
+        const Move &m = candidates[rng() % candidates.size()];
+        board.makeMove(m.x, m.y);
+        moves.push_back(m);
+    }
+}
+
+GameRecord playGame(const EngineSettings &blackSettings, const EngineSettings &whiteSettings,
+                    int openingPlies, uint64_t openingSeed) {
+    SearchEngine black(blackSettings.config);
+    SearchEngine white(whiteSettings.config);
+    GameRecord record;
+    record.result = 0;
+    Board board;
+    playOpening(board, record.moves, openingPlies, openingSeed);
+    int stones = board.countStones(Player::Black) + board.countStones(Player::White);
+    while (!board.hasWinner() && stones < 144) {
+        Player side = board.sideToMove();
+        bool blackToMove = side == Player::Black;
+        SearchEngine &engine = blackToMove ? black : white;
+        int timeMs = blackToMove ? blackSettings.moveTimeMs() : whiteSettings.moveTimeMs();
+        Move m = engine.findBestMove(board, side, timeMs);
+        record.samples.push_back(makeSample(board, engine.lastSearchStats().score));
+        if (m.x < 0 || m.x >= 12 || m.y < 0 || m.y >= 12 || !board.makeMove(m.x, m.y)) {
+            // An illegal move loses.
+            record.result = blackToMove ? -1 : 1;
+            record.samples.clear();
+            return record;
+        }
+        record.moves.push_back(m);
+        ++stones;
+    }
+    if (board.checkWin(Player::Black)) record.result = 1;
+    if (board.checkWin(Player::White)) record.result = -1;
+    for (NetworkSample &s : record.samples) {
+        s.result = static_cast<int8_t>(s.side == 0 ? record.result : -record.result);
+    }
+    return record;
+}
+
+// Score of A against B, with Elo estimates and the SPRT.
+struct Tally {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+
+    int games() const { return wins + draws + losses; }
+    double score() const { return games() > 0 ? (wins + 0.5 * draws) / games() : 0.5; }
+    // Variance of the score of one game.  Half a game is added to each of
+    // W, D and L, as the usual GSPRT tools do: otherwise a side that is
+    // still unbeaten has zero variance, which stalls the SPRT and
+    // collapses the Elo interval exactly when one engine is clearly
+    // better.
+    double variance() const {
+        const double prior = 0.5;
+        double w = wins + prior, d = draws + prior, l = losses + prior;
+        double n = w + d + l;
+        double s = (w + 0.5 * d) / n;
+        return (w * (1 - s) * (1 - s) + d * (0.5 - s) * (0.5 - s) + l * s * s) / n;
+    }
+};
+
+double eloFromScore(double s) {
+    s = std::min(std::max(s, 1e-6), 1 - 1e-6);
+    return -400.0 * std::log10(1.0 / s - 1.0);
+}
+
+double scoreFromElo(double elo) {
+    return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+// Log-likelihood ratio of H1: elo = elo1 against H0: elo = elo0, in the
+// usual normal approximation of the trinomial game outcome.
+double sprtLlr(const Tally &t, double elo0, double elo1) {
+    double var = t.variance();
+    double s0 = scoreFromElo(elo0);
+    double s1 = scoreFromElo(elo1);
+    return t.games() * (s1 - s0) * (2 * t.score() - s0 - s1) / (2 * var);
+}
+
+// One line of totals: games, W-L-D, Elo with a 95% interval, and the
+// likelihood of superiority.
+std::string summary(const Tally &t) {
+    std::ostringstream os;
+    double s = t.score();
+    double margin = 1.96 * std::sqrt(t.variance() / std::max(1, t.games()));
+    double los = t.wins + t.losses > 0
+        ? 0.5 * (1.0 + std::erf((t.wins - t.losses) / std::sqrt(2.0 * (t.wins + t.losses))))
+        : 0.5;
+    os << std::fixed << std::setprecision(1) << "games " << t.games() << "  A +" << t.wins
+       << " -" << t.losses << " =" << t.draws << "  score " << 100.0 * s << "%  elo "
+       << eloFromScore(s) << " [" << eloFromScore(s - margin) << ", "
+       << eloFromScore(s + margin) << "]  los " << 100.0 * los << "%";
+    return os.str();
+}
+
+void usage(const char *program) {
+    std::cerr << "usage: " << program << " [--games N] [--concurrency C] [--a SETTINGS]"
+              << " [--b SETTINGS] [--opening-plies K] [--seed S] [--out FILE]"
+              << " [--dump FILE] [--sprt E0 E1]\n";
+}
+
+} // unnamed namespace
+
+int main(int argc, char **argv) {
+    int games = 100;
+    int concurrency = static_cast<int>(std::thread::hardware_concurrency());
+    EngineSettings settings[2];
+    int openingPlies = 2;
+    uint64_t seed = 1;
+    std::string outPath;
+    std::string dumpPath;
+    bool sprt = false;
+    double elo0 = 0.0, elo1 = 0.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--games" && hasValue) {
+            games = std::atoi(argv[++i]);
+        } else if (arg == "--concurrency" && hasValue) {
+            concurrency = std::atoi(argv[++i]);
+        } else if ((arg == "--a" || arg == "--b") && hasValue) {
+            if (!parseSettings(argv[++i], settings[arg == "--a" ? 0 : 1])) {
+                std::cerr << "bad settings: " << argv[i] << "\n";
+                return 2;
+            }
+        } else if (arg == "--opening-plies" && hasValue) {
+            openingPlies = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--out" && hasValue) {
+            outPath = argv[++i];
+        } else if (arg == "--dump" && hasValue) {
+            dumpPath = argv[++i];
+        } else if (arg == "--sprt" && i + 2 < argc) {
+            sprt = true;
+            elo0 = std::atof(argv[++i]);
+            elo1 = std::atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (games <= 0 || openingPlies < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    concurrency = std::max(1, std::min(concurrency, games));
+    std::ofstream out;
+    if (!outPath.empty()) {
+        out.open(outPath, std::ios::app);
+        if (!out) {
+            std::cerr << "cannot open " << outPath << "\n";
+            return 1;
+        }
+    }
+    std::ofstream dump;
+    if (!dumpPath.empty()) {
+        dump.open(dumpPath, std::ios::app | std::ios::binary);
+        if (!dump) {
+            std::cerr << "cannot open " << dumpPath << "\n";
+            return 1;
+        }
+    }
+    // Board fills its Zobrist tables on first use; do it before the
+    // workers start.
+    Board warmUp;
+    (void)warmUp;
+
+    // Bounds on the LLR for alpha = beta = 0.05.
+    const double lowerBound = std::log(0.05 / 0.95);
+    const double upperBound = std::log(0.95 / 0.05);
+    std::atomic<int> nextGame(0);
+    std::atomic<bool> finished(false);
+    std::mutex lock;
+    Tally tally;
+    std::string verdict;
+
+    auto worker = [&]() {
+        while (!finished.load()) {
+            int game = nextGame.fetch_add(1);
+            if (game >= games) break;
+            // In the first game of a pair A plays black.
+            bool aIsBlack = game % 2 == 0;
+            uint64_t openingSeed = seed * 1000003 + static_cast<uint64_t>(game / 2);
+            GameRecord record = playGame(settings[aIsBlack ? 0 : 1], settings[aIsBlack ? 1 : 0],
+                                         openingPlies, openingSeed);
+            int aResult = aIsBlack ? record.result : -record.result;
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (finished.load()) break;
+            if (aResult > 0) {
+                ++tally.wins;
+            } else if (aResult < 0) {
+                ++tally.losses;
+            } else {
+                ++tally.draws;
+            }
+            const char *result = record.result > 0 ? "1-0" : record.result < 0 ? "0-1" : "1/2-1/2";
+            if (out) {
+                out << game << (aIsBlack ? " A B " : " B A ") << result << " :";
+                for (const Move &m : record.moves) out << " " << m.x << " " << m.y;
+                out << std::endl;
+            }
+            if (dump && !record.samples.empty()) {
+                dump.write(reinterpret_cast<const char *>(record.samples.data()),
+                           record.samples.size() * sizeof(NetworkSample));
+                dump.flush();
+            }
+            std::cout << "game " << game << " " << (aIsBlack ? "A-B " : "B-A ") << result
+                      << "  " << summary(tally);
+            if (sprt) {
+                double llr = sprtLlr(tally, elo0, elo1);
+                std::cout << std::fixed << std::setprecision(2) << "  llr " << llr << " ("
+                          << lowerBound << ", " << upperBound << ")";
+                if (llr >= upperBound || llr <= lowerBound) {
+                    verdict = llr >= upperBound ? "H1 accepted" : "H0 accepted";
+                    finished.store(true);
+                }
+            }
+            std::cout << std::endl;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int i = 0; i < concurrency; ++i) pool.emplace_back(worker);
+    for (auto &t : pool) t.join();
+
+    std::cout << summary(tally) << "\n";
+    if (sprt) {
+        std::cout << std::fixed << std::setprecision(1) << "sprt elo0 " << elo0 << " elo1 " << elo1 << ": "
+                  << (verdict.empty() ? "inconclusive" : verdict) << "\n";
+    }
+    return 0;
+}